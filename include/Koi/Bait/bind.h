@@ -0,0 +1,17 @@
+#ifndef KOIBAITBIND_H
+#define KOIBAITBIND_H
+
+
+#include <triton/context.hpp>
+#include "Koi/swimmer.h"
+
+
+/**
+ * Hook every function that has a Bait by name.
+ * @param s - Swimmer to hook.
+ * @return the number of functions hooked.
+ */
+size_t koi_bind(Swimmer *s);
+
+
+#endif
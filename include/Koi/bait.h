@@ -2,6 +2,7 @@
 #define KOIBAIT_H
 
 #include "Koi/Bait/alloc.h"
+#include "Koi/Bait/bind.h"
 #include "Koi/Bait/io.h"
 #include "Koi/Bait/string.h"
 
@@ -13,11 +13,21 @@ protected:
         Dead,
     };
     BufferState state;
+    size_t granularity;
     triton::uint64 origin;
     triton::uint64 sink;
 
+
+    /**
+     * Find the symbolic variable holding a byte of the buffer.
+     * @param i - Offset of the byte.
+     * @param shift - Where to store the bit offset of the byte in the variable.
+     * @return the index of the variable, or vars.size() if not symbolized.
+     */
+    size_t __locate(size_t i, triton::uint32 *shift);
+
 public:
-    /* A buffer is a Cove with an alias, and symbolic variables */
+    /* A buffer is a Cove with an alias, and symbolic variables of bytes or words */
     std::string alias;
     std::vector<triton::engines::symbolic::SharedSymbolicVariable> vars;
 
@@ -28,9 +38,10 @@ public:
      * @param addr - Address that the buffer was created.
      * @param ptr - Address of the buffer
      * @param len - Size of the buffer
+     * @param gran - Bytes per symbolic variable, 1 or 8 (default=1)
      * @return a new Buffer.
      */
-    Buffer(std::string id, triton::uint64 addr, triton::uint64 ptr, size_t len);
+    Buffer(std::string id, triton::uint64 addr, triton::uint64 ptr, size_t len, size_t gran=1);
 
 
     /**
@@ -41,6 +52,14 @@ public:
     bool kill(triton::uint64 addr);
 
 
+    /**
+     * Mark a dead buffer as live again, undoing a kill.
+     * @param addr - Sink to restore.
+     * @return true if the buffer was previously dead.
+     */
+    bool revive(triton::uint64 addr);
+
+
     /**
      * Check the liveliness of a Buffer.
      * @return true if the buffer is live, else false.
@@ -48,6 +67,32 @@ public:
     bool stat();
 
 
+    /**
+     * Get the number of bytes per symbolic variable.
+     * @return 1 for byte variables, or 8 for word variables.
+     */
+    size_t getGranularity();
+
+
+    /**
+     * Get the AST of a single byte, extracted from its variable as needed.
+     * @param ctx - AST context to build the byte in.
+     * @param i - Offset of the byte.
+     * @return the AST of the byte, or nullptr if not symbolized.
+     */
+    triton::ast::SharedAbstractNode getByteAst(const triton::ast::SharedAstContext& ctx, size_t i);
+
+
+    /**
+     * Get the value of a single byte from a model.
+     * @param model - Model to decode.
+     * @param i - Offset of the byte.
+     * @param value - Where to store the value of the byte.
+     * @return true if the model holds the byte's variable.
+     */
+    bool getByteValue(const std::unordered_map<long unsigned int, triton::engines::solver::SolverModel>& model, size_t i, triton::uint8 *value);
+
+
     /**
      * Get the last address where the buffer state was changed
      * @return the buffer's sink.
@@ -0,0 +1,193 @@
+#ifndef METRICS_H
+#define METRICS_H
+
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <triton/context.hpp>
+
+
+class Metrics {
+public:
+    /* Phases of a step, each timed exclusive of the phases it interrupts */
+    enum Phase {
+        Idle,
+        Fetch,
+        Processing,
+        Reinject,
+        Hooks,
+        StackAllocation,
+        StackReference,
+        MemoryRead,
+        Solver,
+        Koi,
+        PHASES,
+    };
+
+
+    /* A timer attributes time to a phase while in scope, pausing the phase it interrupted */
+    class Timer {
+    private:
+        Metrics *metrics;
+        Phase prev;
+        triton::uint64 hook;
+        triton::uint64 start;
+
+    public:
+        /**
+         * Constructor, entering a phase.
+         * @param m - Metrics to time, or nullptr to do nothing.
+         * @param p - Phase to enter.
+         * @param addr - Address of a hook to also attribute the time to, or 0 (default=0).
+         * @return a new Timer
+         */
+        Timer(Metrics *m, Phase p, triton::uint64 addr=0);
+
+
+        /**
+         * Destructor, returning to the interrupted phase.
+         */
+        ~Timer();
+
+
+        /**
+         * Return to the interrupted phase before leaving scope.
+         */
+        void stop();
+    };
+
+
+    /* Heat of one instruction */
+    class Heat {
+    public:
+        triton::uint64 executions = 0;
+        triton::uint64 solverNanos = 0;
+    };
+
+
+    /* New class members */
+    std::atomic<triton::uint64> cacheHits{0};
+    std::atomic<triton::uint64> forks{0};
+    std::atomic<triton::uint64> heapAllocations{0};
+    std::atomic<triton::uint64> hooksFired{0};
+    bool heatMap = false;
+    std::atomic<triton::uint64> instructions{0};
+    std::atomic<triton::uint64> outOfMemory{0};
+    std::atomic<triton::uint64> phaseNanos[PHASES] = {};
+    std::atomic<triton::uint64> prunedPaths{0};
+    std::atomic<triton::uint64> sat{0};
+    std::atomic<triton::uint64> solverNanos{0};
+    std::atomic<triton::uint64> symbolicVariables{0};
+    std::atomic<triton::uint64> timeout{0};
+    std::atomic<triton::uint64> unknown{0};
+    std::atomic<triton::uint64> unsat{0};
+
+private:
+    /* New class members */
+    std::unordered_map<triton::uint64, Heat> heat;
+    std::unordered_map<triton::uint64, triton::uint64> hookNanos;
+    triton::uint64 lastPc = 0;
+    std::mutex lock;
+    Phase phase = Idle;
+    triton::uint64 phaseStart = 0;
+
+
+    /**
+     * Switch to another phase, adding the time of the current one.
+     * @param p - Phase to switch to.
+     * @return the phase that was switched from.
+     */
+    Phase __enter(Phase p);
+
+public:
+    /**
+     * Count an executed instruction.
+     * @param pc - Address of the instruction.
+     */
+    void countInstruction(triton::uint64 pc);
+
+
+    /**
+     * Count a solver query and its outcome.
+     * @param status - Status of the query.
+     * @return true if the query was not decided.
+     */
+    bool countQuery(triton::engines::solver::status_e status);
+
+
+    /**
+     * Get the number of solver queries.
+     * @return the number of queries of any outcome.
+     */
+    triton::uint64 getQueries();
+
+
+    /**
+     * Add time spent in the solver to the most recently executed instruction.
+     * @param nanos - Nanoseconds spent in the solver.
+     */
+    void addSolverTime(triton::uint64 nanos);
+
+
+    /**
+     * Add time spent in the solver to an instruction.
+     * @param nanos - Nanoseconds spent in the solver.
+     * @param pc - Address of the instruction.
+     */
+    void addSolverTime(triton::uint64 nanos, triton::uint64 pc);
+
+
+    /**
+     * Get a copy of the heat of every executed instruction.
+     * @return the heat of each instruction, keyed by address.
+     */
+    std::map<triton::uint64, Heat> getHeatMap();
+
+
+    /**
+     * Add time spent in a hook.
+     * @param addr - Address of the hook.
+     * @param nanos - Nanoseconds spent in the hook.
+     */
+    void addHookTime(triton::uint64 addr, triton::uint64 nanos);
+
+
+    /**
+     * Get a copy of the time spent in each hook.
+     * @return the nanoseconds spent in each hook, keyed by address.
+     */
+    std::map<triton::uint64, triton::uint64> getHookTimes();
+
+
+    /**
+     * Get the name of a phase.
+     * @param p - Phase to name.
+     * @return the name of the phase.
+     */
+    static const char *getPhaseName(Phase p);
+
+
+    /**
+     * Read the monotonic clock.
+     * @return nanoseconds since an arbitrary point.
+     */
+    static triton::uint64 now();
+
+
+    /**
+     * Export the counters and heat map as JSON.
+     * @return a JSON object of the metrics.
+     */
+    std::string toJson();
+
+
+    /**
+     * Reset every counter and the heat map.
+     */
+    void clear();
+};
+
+
+#endif
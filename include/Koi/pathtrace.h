@@ -0,0 +1,68 @@
+#ifndef PATHTRACE_H
+#define PATHTRACE_H
+
+#include <iostream>
+#include <string>
+#include <vector>
+#include <triton/context.hpp>
+
+
+class PathTrace {
+public:
+    /* Trace files begin with a magic number that includes the format version */
+    inline static const char MAGIC[8] = {'K', 'O', 'I', 'T', 'R', 'A', 'C', 2};
+
+
+    /* A hook call is a hooked function called along the path, and its return value */
+    class HookCall {
+    public:
+        triton::uint64 pc;
+        triton::uint64 dst;
+        triton::uint64 ret;
+    };
+
+
+    /* A symbolic region is memory symbolized along the path */
+    class SymbolicRegion {
+    public:
+        triton::uint64 ptr;
+        triton::uint64 len;
+        bool heap;
+    };
+
+
+    /* New class members */
+    std::vector<std::pair<triton::uint64, bool>> branches;
+    std::vector<std::pair<triton::uint64, bool>> decisions;
+    triton::uint64 endPc = 0;
+    std::vector<HookCall> hooks;
+    std::vector<triton::uint64> pcs;
+    uint reason = 0;
+    std::vector<SymbolicRegion> regions;
+
+
+    /**
+     * Append the path to a trace file.
+     * @param out - Stream of the trace file, after its magic number.
+     */
+    void write(std::ostream& out) const;
+
+
+    /**
+     * Read the next path of a trace file.
+     * @param in - Stream of the trace file, after its magic number.
+     * @return true if a whole path was read.
+     */
+    bool read(std::istream& in);
+
+
+    /**
+     * Read every path of a trace file.
+     * @param file - Path to the trace file.
+     * @return the paths of the file, empty if it is not a trace file.
+     */
+    static std::vector<PathTrace> load(const std::string& file);
+};
+
+
+#endif
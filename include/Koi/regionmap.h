@@ -0,0 +1,77 @@
+#ifndef REGIONMAP_H
+#define REGIONMAP_H
+
+#include <map>
+#include <string>
+#include <triton/context.hpp>
+
+
+class RegionMap {
+public:
+    /* A region of the address space is a stackframe, heap chunk, or section */
+    enum RegionKind {
+        Stack,
+        Heap,
+        Section,
+    };
+
+
+    /* An entry covers the addresses [lo, hi] of one region */
+    class Entry {
+    public:
+        triton::uint64 lo;
+        triton::uint64 hi;
+        RegionKind kind;
+        triton::uint64 tag;
+        std::string name;
+    };
+
+private:
+    /* New class members */
+    std::map<triton::uint64, Entry> entries;
+    std::map<triton::uint64, std::vector<Entry>> nested;
+
+public:
+    /**
+     * Add a region, replacing any regions it overlaps, or nesting a stack region within stack regions.
+     * @param lo - First address of the region.
+     * @param hi - Last address of the region.
+     * @param kind - Kind of the region.
+     * @param tag - Identifier of the region within its kind.
+     * @param name - Name of the region (optional).
+     */
+    void insert(triton::uint64 lo, triton::uint64 hi, RegionKind kind, triton::uint64 tag, const std::string& name="");
+
+
+    /**
+     * Remove a region, restoring the stack regions it nested within.
+     * @param lo - First address of the region.
+     * @return true if the region existed.
+     */
+    bool erase(triton::uint64 lo);
+
+
+    /**
+     * Remove every region of a kind.
+     * @param kind - Kind of the regions.
+     */
+    void clear(RegionKind kind);
+
+
+    /**
+     * Find the region containing an address.
+     * @param ptr - Address to classify.
+     * @return the region containing ptr, or nullptr if there is none.
+     */
+    const Entry *find(triton::uint64 ptr);
+
+
+    /**
+     * Get the number of regions.
+     * @return the number of regions.
+     */
+    size_t size();
+};
+
+
+#endif
@@ -0,0 +1,64 @@
+#ifndef SHADOWMEMORY_H
+#define SHADOWMEMORY_H
+
+#include <unordered_map>
+#include <vector>
+#include <triton/context.hpp>
+
+
+class ShadowMemory {
+public:
+    /* Each byte of memory is in one allocation state */
+    enum ShadowState : triton::uint8 {
+        Unallocated,
+        Live,
+        Freed,
+        Redzone,
+        StackLocal,
+    };
+
+private:
+    /* Shadow pages are created on first write */
+    static const triton::uint64 PAGE_SIZE = 0x1000;
+
+
+    /* New class members */
+    std::unordered_map<triton::uint64, std::vector<triton::uint8>> pages;
+
+public:
+    /**
+     * Set the state of a range of memory.
+     * @param ptr - Start of the memory range.
+     * @param len - Length of the memory range.
+     * @param state - New state of the bytes.
+     */
+    void set(triton::uint64 ptr, size_t len, ShadowState state);
+
+
+    /**
+     * Get the state of a byte of memory.
+     * @param ptr - Address of the byte.
+     * @return the state of the byte.
+     */
+    ShadowState get(triton::uint64 ptr);
+
+
+    /**
+     * Find the first byte of a range in a poisoned state.
+     * @param ptr - Start of the memory range.
+     * @param len - Length of the memory range.
+     * @param poison - Bitmask of poisoned states, as (1 << state).
+     * @param bad - Where to store the address of the poisoned byte (optional).
+     * @return true if any byte in [ptr, ptr+len-1] is poisoned.
+     */
+    bool check(triton::uint64 ptr, size_t len, triton::uint32 poison, triton::uint64 *bad=nullptr);
+
+
+    /**
+     * Forget the state of all memory.
+     */
+    void clear();
+};
+
+
+#endif
@@ -0,0 +1,168 @@
+#ifndef SOLVERPOOL_H
+#define SOLVERPOOL_H
+
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <future>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <triton/context.hpp>
+
+
+class SolverPool {
+public:
+    /* Queries are classed by the log2 of their AST node count */
+    static const size_t CLASSES = 32;
+
+
+    /* An answer is a model, empty unless the solver found one, its status, and the time it took */
+    class Answer {
+    public:
+        std::unordered_map<long unsigned int, triton::engines::solver::SolverModel> model;
+        triton::engines::solver::status_e status;
+        triton::uint64 nanos = 0;
+    };
+
+private:
+    /* A query is answered by whichever of its jobs finishes first */
+    class Query {
+    public:
+        triton::ast::SharedAbstractNode node;
+        size_t cls;
+        std::promise<Answer> answer;
+        bool done = false;
+        bool raced = false;
+        uint jobs = 0;
+        uint started = 0;
+        uint finished = 0;
+    };
+
+
+    /* A job is one solver's attempt at a query, which may not start before a delay */
+    class Job {
+    public:
+        std::shared_ptr<Query> query;
+        uint solver;
+        std::chrono::steady_clock::time_point notBefore;
+    };
+
+
+    /* New class members */
+    std::deque<Job> jobs;
+    std::mutex lock;
+    triton::uint32 memoryLimit = 0;
+    bool portfolio = false;
+    bool portfolioAvailable = false;
+    uint portfolioDelay = 0;
+    size_t portfolioNodes = 0;
+    triton::uint64 races[CLASSES] = {};
+    triton::engines::solver::solver_e solvers[2];
+    bool stopping = false;
+    triton::uint32 timeout = 0;
+    std::condition_variable wake;
+    triton::uint64 wins[CLASSES][2] = {};
+    std::vector<std::thread> workers;
+
+
+    /**
+     * Queue a job for a query, waking a worker.
+     * @param query - Query to attempt.
+     * @param solver - Index of the solver to attempt with.
+     * @param delay - Milliseconds before the job may start.
+     */
+    void __enqueue(std::shared_ptr<Query> query, uint solver, uint delay);
+
+
+    /**
+     * Attempt a query, answering it if no other job has yet.
+     * @param job - Job to attempt.
+     * @param engines - The worker's solvers.
+     */
+    void __solve(Job &job, triton::engines::solver::SolverEngine *engines);
+
+
+    /**
+     * Get the solver that has won most races for a class of query.
+     * @param cls - Class of the query.
+     * @return the index of the preferred solver, or -1 if it should be raced.
+     */
+    int __route(size_t cls);
+
+
+    /**
+     * Run jobs until the pool is stopped.
+     */
+    void __work();
+
+
+public:
+    /**
+     * Constructor
+     * @param n - Number of worker threads.
+     * @param kind - Solver for each worker to use.
+     * @return a new SolverPool
+     */
+    SolverPool(uint n, triton::engines::solver::solver_e kind);
+
+
+    /**
+     * Destructor, waiting for running queries to finish.
+     */
+    ~SolverPool();
+
+
+    /**
+     * Queue a query for a model.
+     * @param node - Constraint to solve.
+     * @return a future answer for the constraint.
+     */
+    std::future<Answer> submit(const triton::ast::SharedAbstractNode& node);
+
+
+    /**
+     * Limit the resources of each query.
+     * @param ms - Milliseconds before a query times out, or 0 for no limit.
+     * @param mb - Megabytes a query may use, or 0 for no limit.
+     */
+    void setLimits(triton::uint32 ms, triton::uint32 mb);
+
+
+    /**
+     * Race both Z3 and Bitwuzla on hard queries.
+     * @param enabled - If the portfolio should be used.
+     * @param nodes - Number of AST nodes for a query to be raced immediately.
+     * @param delay - Milliseconds before a smaller query is raced.
+     * @return true if both solvers are available.
+     */
+    bool setPortfolio(bool enabled, size_t nodes, uint delay);
+
+
+    /**
+     * Get the number of races a solver has won for a class of query.
+     * @param cls - Class of the query.
+     * @param kind - Solver to query.
+     * @return the number of races won.
+     */
+    triton::uint64 getWins(size_t cls, triton::engines::solver::solver_e kind);
+
+
+    /**
+     * Get the number of worker threads.
+     * @return the number of worker threads.
+     */
+    size_t size();
+
+
+    /**
+     * Count the distinct nodes of an AST, following references.
+     * @param node - Root of the AST.
+     * @param limit - Count at which to stop.
+     * @return the number of nodes, up to the limit.
+     */
+    static size_t countNodes(const triton::ast::SharedAbstractNode& node, size_t limit);
+};
+
+
+#endif
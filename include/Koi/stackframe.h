@@ -5,9 +5,19 @@
 #include "Koi/stackframe.h"
 
 class Stackframe: public Cove {
+public:
+    /* A slot is the span from an accessed offset up to the previous access */
+    class Slot {
+    public:
+        triton::uint64 offs;
+        size_t len;
+    };
+
 private:
-    /* A stackframe is a Cove with a record of accessed offsets */
+    /* A stackframe is a Cove with a sorted set of accessed offsets */
     std::vector<triton::uint64> accesses;
+    std::vector<Slot> layout;
+    bool layoutValid;
 
 public:
     /**
@@ -34,6 +44,13 @@ public:
     bool addAccess(triton::uint64 offs);
 
 
+    /**
+     * Remove an access offset from a Stackframe
+     * @param offs - Offset of the access.
+     */
+    void removeAccess(triton::uint64 offs);
+
+
     /**
      * Get the length until the next access.
      * @param offs - Offset to start search from.
@@ -42,6 +59,13 @@ public:
     size_t getAccessGap(triton::uint64 offs);
 
 
+    /**
+     * Get the layout of the stackframe, cached until the next new access.
+     * @return the slots of the stackframe in order of offset.
+     */
+    const std::vector<Slot>& getLayout();
+
+
     /**
      * Update the stackframe information
      * @param a - New address of the stackframe
@@ -2,39 +2,268 @@
 #define SWIMMER_H
 
 #include <triton/context.hpp>
+#include <deque>
+#include <fstream>
+#include <future>
+#include <map>
+#include <memory>
 #include <optional>
+#include <unordered_set>
 #include "Koi/buffer.h"
+#include "Koi/metrics.h"
+#include "Koi/pathtrace.h"
+#include "Koi/regionmap.h"
+#include "Koi/shadowmemory.h"
+#include "Koi/solverpool.h"
 #include "Koi/stackframe.h"
+#include "Koi/tracesink.h"
+
+class Elfivator;
 
 
 class Swimmer: public triton::Context {
+public:
+    /* A path can terminate for several reasons */
+    enum PathEnd {
+        Target,
+        DeadEnd,
+        Return,
+        Exhausted,
+        Undefined,
+        Halt,
+        Diverged,
+    };
+
+    /* A step-wise exploration returns control for several reasons */
+    enum StepResult {
+        Paused,
+        Forked,
+        Succeeded,
+        Finished,
+    };
+
+    /* A file is loaded by its sections, or by its PT_LOAD segments */
+    enum LoadMode {
+        Sections,
+        Segments,
+    };
+
+    /* A branch side the solver could not decide can be handled several ways */
+    enum UnknownPolicy {
+        Skip,
+        Optimistic,
+        Defer,
+    };
+
+    /* Outcomes of the unknown policy, while query outcomes are counted in metrics */
+    class SolverStats {
+    public:
+        triton::uint64 skipped = 0;
+        triton::uint64 followed = 0;
+        triton::uint64 deferred = 0;
+    };
+
 private:
     /* Ease of use constants (temporary) */
     static const uint STACK_START = 0x7ffffffe;
     static const uint STACK_END   = 0x70000000;
     static const uint HEAP_START = 0x1000000;
     static const uint HEAP_END   = 0x2000000;
+    static const uint LOAD_BASE  = 0x100000;
+    static const uint PAGE_SIZE  = 0x1000;
 
 
     /* Hook typedefs */
     typedef void (*InsnHook)(Swimmer*, triton::arch::Instruction);
     typedef triton::uint64 (*FuncHook)(Swimmer*, triton::uint64);
+    typedef void (*PathHook)(Swimmer*, PathEnd, triton::uint64);
+    typedef void (*AccessHook)(Swimmer*, triton::uint64, triton::arch::MemoryAccess, ShadowMemory::ShadowState);
+    typedef void (*WatchHook)(Swimmer*, triton::uint64, triton::arch::MemoryAccess, bool);
 
 
     /* Verbosity typedef */
     typedef unsigned char SV_FLAG;
 
 
+    /* A fork is the fallthrough of a branch, resumed once the jump is explored */
+    class Fork {
+    public:
+        triton::uint64 pc;
+        bool jump;
+        triton::uint64 dst;
+        triton::uint64 rbp;
+        size_t nBranches;
+        size_t nCnstrs;
+        size_t nDecisions;
+        size_t nFrames;
+        size_t nRegions;
+        size_t nPcs;
+        size_t nHooks;
+        triton::ast::SharedAbstractNode cnstr;
+        std::unordered_map<long unsigned int, triton::engines::solver::SolverModel> model;
+        uint fid;
+        uint depth;
+    };
+
+
+    /* A speculation is a fork whose feasibility is still being solved */
+    class Speculation {
+    public:
+        Fork fork;
+        size_t nForks;
+        std::future<SolverPool::Answer> taken;
+        std::future<SolverPool::Answer> flipped;
+    };
+
+
+    /* A deferral is a fork the solver could not decide, retried once all else is explored */
+    class Deferral {
+    public:
+        Fork fork;
+        std::vector<std::pair<triton::uint64, bool>> branches;
+        std::vector<std::pair<triton::uint64, bool>> decisions;
+    };
+
+
+    /* The entry is the state an exploration began in, which deferrals are resumed from */
+    class Entry {
+    public:
+        triton::uint64 pc;
+        triton::uint64 rbp;
+        triton::uint64 rsp;
+        size_t nBranches;
+        size_t nCnstrs;
+        size_t nDecisions;
+        size_t nFrames;
+        size_t nRegions;
+    };
+
+
+    /* A lazy region is symbolized a byte at a time, the first time each byte is read */
+    class LazyRegion {
+    public:
+        size_t len;
+        std::string name;
+        bool stack;
+    };
+
+
+    /* A region is memory symbolized by Koi, or a heap chunk freed, undone when its path is abandoned */
+    class Region {
+    public:
+        triton::uint64 ptr;
+        size_t len;
+        bool heap;
+        bool freed = false;
+        triton::uint64 sink = 0;
+        std::vector<triton::uint64> drained;
+        std::optional<Buffer> reused;
+        std::vector<std::pair<triton::uint64, LazyRegion>> displaced;
+    };
+
+
+    /* A frame change is a stackframe pushed, popped, updated or accessed, undone when its path is abandoned */
+    enum FrameChangeKind {
+        FramePush,
+        FramePop,
+        FrameUpdate,
+        FrameAccess,
+    };
+    class FrameChange {
+    public:
+        FrameChangeKind kind;
+        Stackframe frame;
+        triton::uint64 offs = 0;
+    };
+
+
+    /* A heap chunk is live, quarantined once freed, or free to reuse */
+    enum ChunkState {
+        Live,
+        Quarantined,
+        Free,
+    };
+
+
+    /* A watchpoint calls a hook when an address range is read or written */
+    class Watchpoint {
+    public:
+        triton::uint64 lo;
+        triton::uint64 hi;
+        WatchHook callback;
+        bool read;
+        bool write;
+    };
+
+
+    /* Pages in the bitmap of watched pages, covering the low 4 GiB */
+    static const triton::uint64 WATCH_PAGES = 0x100000;
+
+
+    /* A load span is a section or segment of the image, copied into memory a page at a time */
+    class LoadSpan {
+    public:
+        triton::uint64 addr;
+        const unsigned char *data;
+        size_t filesz;
+        size_t memsz;
+    };
+
+
     /* New class members */
+    std::vector<AccessHook> accessHooks;
+    triton::uint64 backtracks = 0;
+    std::vector<std::pair<triton::uint64, bool>> branches;
     std::vector<triton::uint64> deadEnds;
+    std::deque<Deferral> deferred;
     uint depth = 0;
+    Entry entry;
+    bool exploring = false;
+    uint exploreMaxDepth = 0;
+    uint exploreMaxVisits = 0;
+    triton::uint64 exploreTarget = 0;
     uint fid = 0;
+    std::vector<Fork> forks;
+    std::vector<FrameChange> frameJournal;
     std::unordered_map<triton::uint64, std::vector<FuncHook>> funcHooks;
-    std::unordered_map<triton::uint64, Buffer> heapAllocations;
+    std::map<triton::uint64, Buffer> heapAllocations;
+    std::unordered_map<triton::uint64, ChunkState> heapChunks;
+    std::unordered_map<size_t, std::vector<triton::uint64>> heapFree;
+    std::deque<triton::uint64> heapQuarantine;
+    size_t heapQuarantined = 0;
+    triton::uint64 heapTop = HEAP_START;
     std::unordered_map<triton::uint64, triton::arch::Instruction> injectedInstructions;
+    std::shared_ptr<const Elfivator> image;
     std::unordered_map<triton::uint64, std::vector<InsnHook>> insnHooks;
+    std::unordered_set<triton::uint64> lazyPages;
+    std::map<triton::uint64, LazyRegion> lazyRegions;
+    triton::uint64 loadBias = 0;
+    std::vector<std::pair<triton::uint64, triton::uint64>> loadHoles;
+    LoadMode loadMode = Sections;
+    std::vector<LoadSpan> loadSpans;
+    bool materializing = false;
+    std::vector<PathHook> pathHooks;
+    uint pathFid = 0;
+    std::unordered_set<triton::uint64> pendingTargets;
+    std::ofstream recording;
+    RegionMap regionMap;
+    std::vector<Region> regions;
+    bool replayDiverged = false;
+    size_t replayHook = 0;
+    size_t replayNext = 0;
+    PathTrace replayPath;
+    bool replaying = false;
+    bool resuming = false;
+    ShadowMemory shadow;
+    std::unique_ptr<SolverPool> solverPool;
+    std::deque<Speculation> speculations;
     std::vector<Stackframe> stackframes;
+    std::unordered_map<triton::uint64, std::unordered_map<long unsigned int, triton::engines::solver::SolverModel>> targetModels;
+    PathTrace trace;
     std::unordered_map<triton::uint64, uint> visits;
+    bool watchedFar = false;
+    std::vector<bool> watchedPages;
+    std::vector<Watchpoint> watchpoints;
 
 
     /**
@@ -71,6 +300,270 @@ private:
     bool __handleMemoryRead(triton::uint64 pc, triton::arch::Instruction insn);
 
 
+    /**
+     * Execute a single instruction of the current exploration
+     * @return the state of the exploration after the instruction
+     */
+    StepResult __step();
+
+
+    /**
+     * Resume the most recent fork after a path terminates
+     * @return Paused if a fork was resumed, else Finished
+     */
+    StepResult __backtrack();
+
+
+    /**
+     * Resume a deferred fork by following its path again from the entry
+     * @param d - Deferral to resume.
+     * @return Paused, once the path is set to follow
+     */
+    StepResult __resume(const Deferral& d);
+
+
+    /**
+     * Fork at a symbolic branch without waiting for the solver
+     * @param pc - Address of the branch.
+     * @param ite - Children of the branch if-then-else.
+     * @return the state of the exploration after the branch
+     */
+    StepResult __speculate(triton::uint64 pc, const std::vector<triton::ast::SharedAbstractNode>& ite);
+
+
+    /**
+     * Follow the side of a symbolic branch that Triton concretely took
+     * @param pc - Address of the branch.
+     * @param ite - Children of the branch if-then-else.
+     * @return the state of the exploration after the branch
+     */
+    StepResult __followConcrete(triton::uint64 pc, const std::vector<triton::ast::SharedAbstractNode>& ite);
+
+
+    /**
+     * Follow the recorded side of a symbolic branch without the solver
+     * @param pc - Address of the branch.
+     * @param ite - Children of the branch if-then-else.
+     * @return the state of the exploration after the branch
+     */
+    StepResult __replayBranch(triton::uint64 pc, const std::vector<triton::ast::SharedAbstractNode>& ite);
+
+
+    /**
+     * Collect the answers to speculative forks, oldest first
+     * @param block - Wait for every answer instead of stopping at the first pending one.
+     * @return true if the current path was found infeasible
+     */
+    bool __resolveSpeculations(bool block);
+
+
+    /**
+     * Deliver a terminated path to every path hook
+     * @param reason - Why the path terminated.
+     * @param pc - Address of the final instruction.
+     * @return the state of the exploration after the path
+     */
+    StepResult __endPath(PathEnd reason, triton::uint64 pc);
+
+
+    /**
+     * Concretize expressions written by an instruction that exceed the AST limits
+     * @param insn - Processed instruction.
+     */
+    void __limitExpressions(triton::arch::Instruction& insn);
+
+
+    /**
+     * Mark memory to be symbolized a byte at a time as it is first read
+     * @param ptr - Starting address of the memory.
+     * @param len - Length of the memory.
+     * @param name - Name that each symbolic byte is derived from.
+     * @param stack - If the memory is a stackframe, named downwards from its base.
+     */
+    void __makeLazy(triton::uint64 ptr, size_t len, const std::string& name, bool stack);
+
+
+    /**
+     * Check if an address is in memory marked to be symbolized lazily
+     * @param ptr - Address to check.
+     * @return true if the address is in a lazy region.
+     */
+    bool __isLazy(triton::uint64 ptr);
+
+
+    /**
+     * Prepare the image to be loaded a page at a time
+     * @param base - Address to load the image at.
+     */
+    void __loadImage(triton::uint64 base);
+
+
+    /**
+     * Add a span of the image to be loaded a page at a time
+     * @param addr - Address to load the span at.
+     * @param data - Bytes of the span in the image.
+     * @param filesz - Number of bytes in the image.
+     * @param memsz - Number of bytes in memory, zero-filled past filesz.
+     */
+    void __addSpan(triton::uint64 addr, const unsigned char *data, size_t filesz, size_t memsz);
+
+
+    /**
+     * Mark every page of the image as not yet copied into memory
+     */
+    void __armPages();
+
+
+    /**
+     * Set up the registers and call stack as they are right after loading
+     */
+    void __initState();
+
+
+    /**
+     * Load the pages of a memory range that have not been loaded yet
+     * @param ptr - Start of the memory range.
+     * @param len - Length of the memory range.
+     */
+    void __materializePages(triton::uint64 ptr, size_t len);
+
+
+    /**
+     * Load a page from the segments that cover it
+     * @param page - Address of the page.
+     */
+    void __loadPage(triton::uint64 page);
+
+
+    /**
+     * Find the heap chunk that owns an address
+     * @param ptr - Address to query.
+     * @param strict - If true, the address must start a chunk.
+     * @return the chunk, or the end of heapAllocations if there is no owner.
+     */
+    std::map<triton::uint64, Buffer>::iterator __findHeapChunk(triton::uint64 ptr, bool strict);
+
+
+    /**
+     * Get the size class of a heap allocation
+     * @param len - Length of the allocation.
+     * @return the number of bytes reserved for the allocation.
+     */
+    size_t __heapClass(size_t len);
+
+
+    /**
+     * Remove a chunk from its free list, if it is listed
+     * @param ptr - Starting address of the chunk.
+     * @param cap - Size class of the chunk.
+     */
+    void __unlistFree(triton::uint64 ptr, size_t cap);
+
+
+    /**
+     * Add a stackframe to the region map
+     * @param i - Index of the stackframe.
+     */
+    void __mapFrame(size_t i);
+
+
+    /**
+     * Remove a stackframe from the region map
+     * @param i - Index of the stackframe.
+     */
+    void __unmapFrame(size_t i);
+
+
+    /**
+     * Push a new stackframe for a call
+     */
+    void __pushFrame();
+
+
+    /**
+     * Pop the stackframe of a returning call
+     */
+    void __popFrame();
+
+
+    /**
+     * Undo changes to the call stack, such as when a fork is resumed
+     * @param n - Number of frame changes to keep.
+     */
+    void __rewindFrames(size_t n);
+
+
+    /**
+     * Record memory symbolized by Koi on the current path
+     * @param ptr - Starting address of the memory.
+     * @param len - Length of the memory.
+     */
+    void __journal(triton::uint64 ptr, size_t len);
+
+
+    /**
+     * Release memory symbolized by Koi on an abandoned path
+     * @param n - Number of regions to keep.
+     */
+    void __release(size_t n);
+
+
+    /**
+     * Query the solver for a model, counting the outcome
+     * @param node - Constraint to solve.
+     * @param status - Where to store the status of the query (optional).
+     * @param timeout - Milliseconds before the query times out, or 0 for no limit.
+     * @return a model for the constraint, empty if not found.
+     */
+    std::unordered_map<long unsigned int, triton::engines::solver::SolverModel> __solve(const triton::ast::SharedAbstractNode& node, triton::engines::solver::status_e *status, triton::uint32 timeout);
+
+
+    /**
+     * Get the metrics to time phases with
+     * @return the metrics if phases are timed, else nullptr.
+     */
+    Metrics *__timing();
+
+
+    /**
+     * Count the outcome of a solver query
+     * @param status - Status of the query.
+     * @return true if the query was not decided.
+     */
+    bool __countOutcome(triton::engines::solver::status_e status);
+
+
+    /**
+     * Defer an undecided branch side until all else is explored
+     * @param f - Fork of the undecided side.
+     */
+    void __defer(Fork f);
+
+
+    /**
+     * Check the memory accessed by an instruction against the shadow memory
+     * @param pc - Address of the instruction.
+     * @param insn - Processed instruction.
+     */
+    void __checkAccesses(triton::uint64 pc, triton::arch::Instruction& insn);
+
+
+    /**
+     * Mark the pages of a watched range in the bitmap of watched pages
+     * @param lo - First address of the range.
+     * @param hi - Last address of the range.
+     */
+    void __markWatched(triton::uint64 lo, triton::uint64 hi);
+
+
+    /**
+     * Call the watchpoints covering the memory accessed by an instruction
+     * @param pc - Address of the instruction.
+     * @param insn - Processed instruction.
+     */
+    void __checkWatchpoints(triton::uint64 pc, triton::arch::Instruction& insn);
+
+
     /**
      * Print the values of concrete registers and note symbolic registers
      * @param all - Print all registers, not only general purpose.
@@ -78,6 +571,22 @@ private:
     void __printRegisters(bool all=false);
 
 
+    /**
+     * Add a record of the current path to the trace sink, creating it if needed
+     * @param kind - Kind of the record.
+     * @param a - First value of the record (default=0).
+     * @param b - Second value of the record (default=0).
+     * @param text - Text of the record (default=nullptr).
+     */
+    void __trace(TraceSink::RecordKind kind, triton::uint64 a=0, triton::uint64 b=0, const char *text=nullptr);
+
+
+    /**
+     * Wait until the trace sink has written every record, if there is one
+     */
+    void __flushTrace();
+
+
 public:
     /* Static verbosity flags */
     static const SV_FLAG SV_INSN   = 0b00000001;
@@ -95,16 +604,45 @@ public:
 
 
     /* New class members */
+    triton::uint64 astConcretizations = 0;
+    uint astMaxDepth = 0;
+    size_t astMaxNodes = 0;
+    bool checkAccesses = false;
+    inline static std::string snapshotDir = "";
     std::vector<triton::ast::SharedAbstractNode> cnstrs;
+    uint compactInterval = 0;
+    std::vector<std::pair<triton::uint64, bool>> decisions;
+    triton::uint32 deferredTimeout = 0;
+    size_t heapQuarantineSize = 0x10000;
+    Metrics metrics;
+    uint portfolioDelay = 250;
+    size_t portfolioNodes = 4096;
+    triton::uint32 solverMemoryLimit = 0;
+    bool solverPortfolio = false;
+    SolverStats solverStats;
+    uint solverThreads = 0;
+    triton::uint32 solverTimeout = 0;
+    bool timePhases = false;
+    std::shared_ptr<TraceSink> traceSink;
+    UnknownPolicy unknownPolicy = Skip;
     SV_FLAG verbosity = 0;
 
 
      /**
      * Constructor
      * @param filein - Path to a file to load.
+     * @param mode - Load the file by its sections or PT_LOAD segments (default=Sections).
+     * @param base - Address to load a position independent file at (default=0x100000).
      * @return a new Swimmer
      */
-    Swimmer(const std::string& filein);
+    Swimmer(const std::string& filein, LoadMode mode=Sections, triton::uint64 base=LOAD_BASE);
+
+
+    /**
+     * Return to the state right after loading, so the Swimmer can run another job.
+     * @param unhook - If true, also remove hooks, watchpoints, injections and dead ends (default=false).
+     */
+    void reset(bool unhook=false);
 
 
     /**
@@ -124,6 +662,50 @@ public:
     bool explore(triton::uint64 target=0, uint maxVisits=0, uint maxDepth=0);
 
 
+    /**
+     * Explores the memory pool once for several targets, recording a model for each
+     * @param targets - Desired addresses to execute
+     * @param maxVisits - Maximum number of times to execute the same instruction
+     * @param maxDepth - Maximum fork depth of an execution branch
+     * @return a model for each target that was reached, keyed by target
+     */
+    std::unordered_map<triton::uint64, std::unordered_map<long unsigned int, triton::engines::solver::SolverModel>> exploreTargets(const std::vector<triton::uint64>& targets, uint maxVisits=0, uint maxDepth=0);
+
+
+    /**
+     * Prepare a step-wise exploration from the instruction pointer
+     * @param target - Desired address to execute
+     * @param maxVisits - Maximum number of times to execute the same instruction
+     * @param maxDepth - Maximum fork depth of an execution branch
+     */
+    void beginExplore(triton::uint64 target=0, uint maxVisits=0, uint maxDepth=0);
+
+
+    /**
+     * Record every path explored from now on to a trace file.
+     * @param file - Path to the trace file, or empty to stop recording.
+     * @return true if the trace file was created, or recording stopped.
+     */
+    bool recordPaths(const std::string& file);
+
+
+    /**
+     * Follow a recorded path from the instruction pointer without the solver.
+     * @param path - Recorded path to follow.
+     * @param maxVisits - Maximum number of times to execute the same instruction (default=0).
+     * @return true if every recorded branch and hook call was followed, and the same regions were symbolized.
+     */
+    bool replay(const PathTrace& path, uint maxVisits=0);
+
+
+    /**
+     * Continue a step-wise exploration
+     * @param n - Maximum number of instructions to execute, or 0 for no limit (default=1)
+     * @return the state of the exploration when control is returned
+     */
+    StepResult step(uint n=1);
+
+
     /**
      * Add a hook to an instruction.
      * @param addr - Address of the instruction.
@@ -140,6 +722,50 @@ public:
     void hookFunction(triton::uint64 addr, FuncHook callback);
 
 
+    /**
+     * Add a hook to a function by name, such as an import through the PLT.
+     * @param name - Name of the function.
+     * @param callback - FuncHook to call after instead of the function.
+     * @return true if the name was resolved and hooked.
+     */
+    bool hookFunction(const std::string& name, FuncHook callback);
+
+
+    /**
+     * Add a hook to the end of every explored path.
+     * @param callback - PathHook to call when a path terminates.
+     */
+    void hookPath(PathHook callback);
+
+
+    /**
+     * Add a hook to memory accesses that violate the shadow memory.
+     * Accesses are only checked when checkAccesses is set.
+     * @param callback - AccessHook to call after processing the accessing instruction.
+     */
+    void hookAccess(AccessHook callback);
+
+
+    /**
+     * Add a hook to reads and/or writes of an address range.
+     * @param lo - First address of the range.
+     * @param hi - Last address of the range.
+     * @param callback - WatchHook to call after processing the accessing instruction.
+     * @param read - If true, reads of the range call the hook (default=true).
+     * @param write - If true, writes to the range call the hook (default=true).
+     */
+    void watchMemory(triton::uint64 lo, triton::uint64 hi, WatchHook callback, bool read=true, bool write=true);
+
+
+    /**
+     * Remove the watchpoints of an address range.
+     * @param lo - First address of the range.
+     * @param hi - Last address of the range.
+     * @return the number of watchpoints removed.
+     */
+    size_t unwatchMemory(triton::uint64 lo, triton::uint64 hi);
+
+
     /**
      * Mark an address as dead, stopping execution if it is reached.
      * @param addr - Dead address
@@ -164,6 +790,25 @@ public:
     bool injectJumpCondition(triton::uint64 addr, triton::ast::SharedAbstractNode guard);
 
 
+    /**
+     * Creates a model for a constraint within the solver limits.
+     * @param node - Constraint to solve.
+     * @param status - Where to store the status of the query (optional).
+     * @return a model for the constraint, empty if not found.
+     */
+    std::unordered_map<long unsigned int, triton::engines::solver::SolverModel> getModel(const triton::ast::SharedAbstractNode& node, triton::engines::solver::status_e *status=nullptr);
+
+
+    /**
+     * Creates several models for a constraint within the solver limits.
+     * @param node - Constraint to solve.
+     * @param limit - The number of models to return
+     * @param status - Where to store the status of the query (optional).
+     * @return a vector of models for the constraint
+     */
+    std::vector<std::unordered_map<long unsigned int, triton::engines::solver::SolverModel>> getModels(const triton::ast::SharedAbstractNode& node, uint limit, triton::engines::solver::status_e *status=nullptr);
+
+
     /**
      * Creates a model for the current constraints.
      * @return a model for the current constraints.
@@ -179,6 +824,21 @@ public:
     std::vector<std::unordered_map<long unsigned int, triton::engines::solver::SolverModel>> getSatModels(uint limit);
 
 
+    /**
+     * Drop symbolic expressions that no longer depend on any variable.
+     * @return the number of memory bytes and registers concretized.
+     */
+    size_t compact();
+
+
+    /**
+     * Symbolize lazy memory that has not been written or read yet.
+     * @param ptr - Starting address of the memory.
+     * @param len - Length of the memory.
+     */
+    void materializeMemory(triton::uint64 ptr, size_t len);
+
+
     /**
      * Reads a string from memory
      * @param ptr - Address in memory to read from.
@@ -187,15 +847,34 @@ public:
     std::string readString(triton::uint64 ptr);
 
 
+    /**
+     * Get the address of an imported or defined function.
+     * @param name - Name of the function.
+     * @return the address of the function's PLT stub or body, or 0 if unknown.
+     */
+    triton::uint64 getSymbolAddress(const std::string& name);
+
+
+    /**
+     * Check if memory has a concrete value, loading its pages first.
+     * @param baseAddr - Start of the memory range.
+     * @param size - Length of the memory range (default=1).
+     * @return true if every byte of the range is defined.
+     */
+    bool isConcreteMemoryValueDefined(triton::uint64 baseAddr, triton::usize size=1);
+    bool isConcreteMemoryValueDefined(const triton::arch::MemoryAccess& mem);
+
+
     /**
      * Symbolizes bytes in memory with information on the source.
      * @param id - Identifying name for the memory (fgets, strcpy, etc).
      * @param ptr - Address to be symbolized.
      * @param sink - Address at which the memory was symbolized.
      * @param len - Length of the memory access.
+     * @param gran - Bytes per symbolic variable, 1 or 8 (default=1).
      * @return the Buffer for the memory.
      */
-    Buffer symbolizeNamedMemory(std::string id, triton::uint64 ptr, triton::uint64 sink, size_t len);
+    Buffer symbolizeNamedMemory(std::string id, triton::uint64 ptr, triton::uint64 sink, size_t len, size_t gran=1);
 
 
     /**
@@ -328,6 +1007,22 @@ public:
     bool isStackAddress(triton::uint64 ptr);
 
 
+    /**
+     * Classify an address as a stackframe, heap chunk, or section.
+     * @param ptr - Address to classify.
+     * @return the region containing ptr, or nullptr if there is none.
+     */
+    const RegionMap::Entry *getRegion(triton::uint64 ptr);
+
+
+    /**
+     * Get the allocation state of a byte of memory.
+     * @param ptr - Address of the byte.
+     * @return the state of the byte in the shadow memory.
+     */
+    ShadowMemory::ShadowState getShadowState(triton::uint64 ptr);
+
+
     /**
      * Check if an address belongs to the heap.
      * @param ptr - Address to check
@@ -0,0 +1,129 @@
+#ifndef TRACESINK_H
+#define TRACESINK_H
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <triton/context.hpp>
+
+
+class TraceSink {
+public:
+    /* Each kind of record is one verbose message */
+    enum RecordKind : triton::uint8 {
+        Insn,
+        FuncHook,
+        StepOver,
+        Branch,
+        Alloc,
+        Free,
+        Frame,
+        FrameAccess,
+        FrameEnd,
+        Exhausted,
+        Undefined,
+        NotExecutable,
+        Target,
+        TargetAt,
+        DeadEnd,
+        PathEnd,
+        TooDeep,
+        SpeculationFailed,
+        Concretized,
+        Deferred,
+        InvalidAccess,
+        Compacted,
+        Dropped,
+    };
+
+
+    /* A record is a fixed-size binary trace event, formatted only when written */
+    class Record {
+    public:
+        RecordKind kind;
+        uint fid;
+        uint depth;
+        triton::uint64 a;
+        triton::uint64 b;
+        char text[64];
+    };
+
+
+    /* A writer formats records, on the sink's background thread */
+    typedef std::function<void(const Record&)> Writer;
+
+private:
+    /* New class members */
+    std::atomic<triton::uint64> dropped;
+    std::atomic<size_t> head;
+    std::mutex lock;
+    size_t mask;
+    std::thread printer;
+    triton::uint64 reported;
+    std::vector<Record> ring;
+    std::atomic<bool> sleeping;
+    std::atomic<bool> stopping;
+    std::atomic<size_t> tail;
+    std::condition_variable wake;
+    Writer writer;
+
+
+    /**
+     * Write records as they arrive until stopped
+     */
+    void __print();
+
+public:
+    /**
+     * Constructor
+     * @param w - Writer for each record (default=TraceSink::print).
+     * @param capacity - Records the ring buffer holds, rounded up to a power of two (default=4096).
+     * @return a new TraceSink
+     */
+    TraceSink(Writer w=print, size_t capacity=4096);
+
+
+    /**
+     * Destructor, writing the records that are left.
+     */
+    ~TraceSink();
+
+
+    /**
+     * Add a record without blocking, dropping it if the ring buffer is full.
+     * Only one thread may add records.
+     * @param kind - Kind of the record.
+     * @param a - First value of the record (default=0).
+     * @param b - Second value of the record (default=0).
+     * @param fid - Fork ID of the path (default=0).
+     * @param depth - Depth of the path (default=0).
+     * @param text - Text of the record, truncated to fit (default=nullptr).
+     */
+    void push(RecordKind kind, triton::uint64 a=0, triton::uint64 b=0, uint fid=0, uint depth=0, const char *text=nullptr);
+
+
+    /**
+     * Wait until every record added so far has been written, then report any newly dropped records.
+     */
+    void flush();
+
+
+    /**
+     * Get the number of records dropped because the ring buffer was full.
+     * @return the number of dropped records.
+     */
+    triton::uint64 getDropped();
+
+
+    /**
+     * Write a record as ANSI-coloured text to stdout.
+     * @param r - Record to write.
+     */
+    static void print(const Record& r);
+};
+
+
+#endif
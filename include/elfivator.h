@@ -2,35 +2,134 @@
 #define ELFIVATOR_H
 
 #include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
 #include <vector>
 
 class Elfivator {
 private:
+    /* A section is a span over the mapped file */
     class ElfSection {
     public:
-        std::vector<unsigned char>data;
+        const unsigned char *data;
         std::string name;
         size_t offset;
         size_t size;
+        uint64_t flags;
     };
 
+
+    /* A segment is a PT_LOAD program header, with its file bytes in the mapping */
+    class ElfSegment {
+    public:
+        const unsigned char *data;
+        size_t vaddr;
+        size_t filesz;
+        size_t memsz;
+        unsigned int flags;
+    };
+
+
+    /* The file stays mapped for the life of the Elfivator */
+    void *image = nullptr;
+    size_t imageSize = 0;
+
+
+    /**
+     * Map a file into memory, so its sections can be read in place
+     * @param filein - Path to the file to map.
+     * @return true if the file was mapped.
+     */
+    bool mapFile(const std::string& filein);
+
+
+    /**
+     * Hash the mapped file with 64-bit FNV-1a
+     * @return the hash of the file.
+     */
+    uint64_t hashImage();
+
+
     /**
      * Parse the contents of an elf into this
      * @param filein - Path to file to parse
      */
     void readElfFile(const std::string& filein);
 
+
+    /**
+     * Read the parsed file from a snapshot
+     * @param path - Path to the snapshot.
+     * @return true if the snapshot was read.
+     */
+    bool readSnapshot(const std::string& path);
+
+
+    /**
+     * Write the parsed file as a snapshot
+     * @param path - Path to the snapshot.
+     */
+    void writeSnapshot(const std::string& path);
+
+
+    /**
+     * Find a section by name
+     * @param name - Name of the section.
+     * @return the section, or nullptr if there is none.
+     */
+    const ElfSection *findSection(const std::string& name);
+
+
+    /**
+     * Parse the function symbols defined by the symbol tables
+     */
+    void readSymbols();
+
+
+    /**
+     * Parse the PLT stubs of imported functions
+     */
+    void readImports();
+
 public:
     /* New class members */
     std::vector<ElfSection> sections;
-    size_t entry;
+    std::vector<ElfSegment> segments;
+    std::unordered_map<std::string, size_t> imports;
+    std::unordered_map<std::string, size_t> symbols;
+    size_t entry = 0;
+    uint64_t hash = 0;
+    bool pie = false;
 
     /**
      * Constructor
      * @param filein - Path to a file to load.
+     * @param snapshotDir - Directory of snapshots, or empty to always parse (default="").
      * @return a new Elfivator
      */
-    Elfivator(const std::string& filein);
+    Elfivator(const std::string& filein, const std::string& snapshotDir="");
+
+
+    /**
+     * Get the image of a file shared by every user in the process, loading it if needed.
+     * @param filein - Path to a file to load.
+     * @param snapshotDir - Directory of snapshots, or empty to always parse (default="").
+     * @return the shared, read-only image of the file.
+     */
+    static std::shared_ptr<const Elfivator> share(const std::string& filein, const std::string& snapshotDir="");
+
+
+    /**
+     * Destructor, unmapping the file.
+     */
+    ~Elfivator();
+
+
+    /* Sections point into the mapping, so it is never shared */
+    Elfivator(const Elfivator&) = delete;
+    Elfivator& operator=(const Elfivator&) = delete;
 };
 
 #endif
@@ -0,0 +1,30 @@
+#include <triton/context.hpp>
+#include "Koi/Bait/alloc.h"
+#include "Koi/Bait/bind.h"
+#include "Koi/Bait/io.h"
+#include "Koi/Bait/string.h"
+
+
+/**
+ * Hook every function that has a Bait by name.
+ * Functions that the file neither imports nor defines are skipped.
+ * @param s - Swimmer to hook.
+ * @return the number of functions hooked.
+ */
+size_t koi_bind(Swimmer *s) {
+    const std::pair<const char *, triton::uint64 (*)(Swimmer *, triton::uint64)> baits[] = {
+        {"calloc", koi_calloc},
+        {"fgets", koi_fgets},
+        {"free", koi_free},
+        {"malloc", koi_malloc},
+        {"realloc", koi_realloc},
+        {"strchr", koi_strchr},
+        {"strcpy", koi_strcpy},
+        {"strlen", koi_strlen},
+        {"strncpy", koi_strncpy},
+    };
+    size_t n = 0;
+    for(auto& bait : baits)
+        n += s->hookFunction(bait.first, bait.second);
+    return n;
+}
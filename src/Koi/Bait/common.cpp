@@ -39,6 +39,10 @@ triton::uint64 __getSatisfiableRegisterValue(Swimmer *s, triton::arch::Register
  * @param len - Number of bytes to copy.
  */
 void __copyConcretesAndConstraints(Swimmer *s, triton::uint64 dst, triton::uint64 src, size_t len) {
+    // Lazy memory must exist before it is copied
+    s->materializeMemory(src, len);
+    s->materializeMemory(dst, len);
+
     for(size_t i = 0; i < len; i++) {
         // Symbolic memory
         if(s->isMemorySymbolized(src + i)) {
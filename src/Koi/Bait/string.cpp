@@ -16,6 +16,7 @@ triton::uint64 __deduceStringSize(Swimmer *s, triton::uint64 ptr);
  triton::uint64 koi_strchr(Swimmer *s, triton::uint64 addr) {
     // Assume the pointer is concrete
     triton::uint64 ptr_in = __getSatisfiableRegisterValue(s, s->registers.x86_rdi);
+    s->materializeMemory(ptr_in, 1);
 
     // Concrete string
     if(!s->isMemorySymbolized(ptr_in)) {
@@ -129,6 +130,7 @@ triton::uint64 koi_strlen(Swimmer *s, triton::uint64 addr) {
     // No string found
     if(full_len == 0)
         return 0;
+    s->materializeMemory(ptr, full_len);
 
     // Search for earliest defined or latest satisfiable null byte
     len = full_len;
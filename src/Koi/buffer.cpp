@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <iomanip>
 #include <triton/context.hpp>
 #include "Koi/buffer.h"
@@ -14,13 +15,15 @@
  * @param addr - Address that the buffer was created.
  * @param ptr - Address of the buffer
  * @param len - Size of the buffer
+ * @param gran - Bytes per symbolic variable, 1 or 8 (default=1)
  * @return a new Buffer with no symbolic variables.
  */
-Buffer::Buffer(std::string id, triton::uint64 addr, triton::uint64 ptr, size_t len) : Cove(ptr, len) {
+Buffer::Buffer(std::string id, triton::uint64 addr, triton::uint64 ptr, size_t len, size_t gran) : Cove(ptr, len) {
     std::stringstream ss;
     ss << id << "<--0x" << std::hex << addr;
     alias = ss.str();
     vars = {};
+    granularity = gran == 8 ? 8 : 1;
     state = BufferState::Live;
     sink = addr;
     origin = addr;
@@ -41,6 +44,20 @@ bool Buffer::kill(triton::uint64 addr) {
 }
 
 
+/**
+ * Mark a dead buffer as live again, undoing a kill.
+ * @param addr - Sink to restore.
+ * @return true if the buffer was previously dead.
+ */
+bool Buffer::revive(triton::uint64 addr) {
+    if(state == BufferState::Live)
+        return false;
+    sink = addr;
+    state = BufferState::Live;
+    return true;
+}
+
+
 /**
  * Check the liveliness of a Buffer.
  * @return true if the buffer is live, else false.
@@ -50,6 +67,50 @@ bool Buffer::stat() {
 }
 
 
+/**
+ * Get the number of bytes per symbolic variable.
+ * @return 1 for byte variables, or 8 for word variables.
+ */
+size_t Buffer::getGranularity() {
+    return granularity;
+}
+
+
+/**
+ * Get the AST of a single byte, extracted from its variable as needed.
+ * @param ctx - AST context to build the byte in.
+ * @param i - Offset of the byte.
+ * @return the AST of the byte, or nullptr if not symbolized.
+ */
+triton::ast::SharedAbstractNode Buffer::getByteAst(const triton::ast::SharedAstContext& ctx, size_t i) {
+    triton::uint32 shift;
+    size_t v = __locate(i, &shift);
+    if(v >= vars.size() || vars[v] == nullptr)
+        return nullptr;
+    triton::ast::SharedAbstractNode node = ctx->variable(vars[v]);
+    if(vars[v]->getSize() == 8)
+        return node;
+    return ctx->extract(shift + 7, shift, node);
+}
+
+
+/**
+ * Get the value of a single byte from a model.
+ * @param model - Model to decode.
+ * @param i - Offset of the byte.
+ * @param value - Where to store the value of the byte.
+ * @return true if the model holds the byte's variable.
+ */
+bool Buffer::getByteValue(const std::unordered_map<long unsigned int, triton::engines::solver::SolverModel>& model, size_t i, triton::uint8 *value) {
+    triton::uint32 shift;
+    size_t v = __locate(i, &shift);
+    if(v >= vars.size() || vars[v] == nullptr || !model.count(vars[v]->getId()))
+        return false;
+    *value = triton::uint8(triton::uint64(model.at(vars[v]->getId()).getValue() >> shift) & 0xFF);
+    return true;
+}
+
+
 /**
  * Get the last address where the buffer state was changed
  * @return the buffer's sink.
@@ -65,4 +126,31 @@ triton::uint64 Buffer::getSink() {
  */
 triton::uint64 Buffer::getOrigin() {
     return origin;
-}
\ No newline at end of file
+}
+
+
+/***********************/
+/* PROTECTED FUNCTIONS */
+/***********************/
+
+
+/**
+ * Find the symbolic variable holding a byte of the buffer.
+ * Word buffers hold whole words first, then a variable for each trailing byte.
+ * A lazily symbolized buffer holds nullptr for bytes not yet read.
+ * @param i - Offset of the byte.
+ * @param shift - Where to store the bit offset of the byte in the variable.
+ * @return the index of the variable, or vars.size() if not symbolized.
+ */
+size_t Buffer::__locate(size_t i, triton::uint32 *shift) {
+    *shift = 0;
+    if(i >= sz)
+        return vars.size();
+    if(granularity == 1)
+        return std::min(i, vars.size());
+    size_t words = sz / granularity;
+    size_t v = i < words * granularity ? i / granularity : words + (i - words * granularity);
+    if(i < words * granularity)
+        *shift = triton::uint32(8 * (i % granularity));
+    return std::min(v, vars.size());
+}
@@ -0,0 +1,265 @@
+#include <chrono>
+#include <sstream>
+#include <triton/context.hpp>
+#include "Koi/metrics.h"
+
+
+/********************/
+/* PUBLIC FUNCTIONS */
+/********************/
+
+
+/**
+ * Constructor, entering a phase.
+ * @param m - Metrics to time, or nullptr to do nothing.
+ * @param p - Phase to enter.
+ * @param addr - Address of a hook to also attribute the time to, or 0 (default=0).
+ * @return a new Timer
+ */
+Metrics::Timer::Timer(Metrics *m, Phase p, triton::uint64 addr) : metrics(m), prev(Idle), hook(addr), start(0) {
+    if(metrics == nullptr)
+        return;
+    if(hook != 0)
+        start = now();
+    prev = metrics->__enter(p);
+}
+
+
+/**
+ * Destructor, returning to the interrupted phase.
+ */
+Metrics::Timer::~Timer() {
+    stop();
+}
+
+
+/**
+ * Return to the interrupted phase before leaving scope.
+ * A hook is attributed all of its time, including any phases it entered.
+ */
+void Metrics::Timer::stop() {
+    if(metrics == nullptr)
+        return;
+    metrics->__enter(prev);
+    if(hook != 0)
+        metrics->addHookTime(hook, now() - start);
+    metrics = nullptr;
+}
+
+
+/**
+ * Count an executed instruction.
+ * The instruction is only added to the heat map if it is kept.
+ * @param pc - Address of the instruction.
+ */
+void Metrics::countInstruction(triton::uint64 pc) {
+    instructions.fetch_add(1, std::memory_order_relaxed);
+    if(!heatMap)
+        return;
+    std::lock_guard<std::mutex> guard(lock);
+    heat[pc].executions++;
+    lastPc = pc;
+}
+
+
+/**
+ * Count a solver query and its outcome.
+ * @param status - Status of the query.
+ * @return true if the query was not decided.
+ */
+bool Metrics::countQuery(triton::engines::solver::status_e status) {
+    switch(status) {
+        case triton::engines::solver::SAT:
+            sat.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        case triton::engines::solver::UNSAT:
+            unsat.fetch_add(1, std::memory_order_relaxed);
+            return false;
+        case triton::engines::solver::TIMEOUT:
+            timeout.fetch_add(1, std::memory_order_relaxed);
+            break;
+        case triton::engines::solver::OUTOFMEM:
+            outOfMemory.fetch_add(1, std::memory_order_relaxed);
+            break;
+        default:
+            unknown.fetch_add(1, std::memory_order_relaxed);
+            break;
+    }
+    return true;
+}
+
+
+/**
+ * Get the number of solver queries.
+ * @return the number of queries of any outcome.
+ */
+triton::uint64 Metrics::getQueries() {
+    return sat + unsat + timeout + outOfMemory + unknown;
+}
+
+
+/**
+ * Add time spent in the solver to the most recently executed instruction.
+ * Only the exploring thread counts instructions, so it alone may call this.
+ * @param nanos - Nanoseconds spent in the solver.
+ */
+void Metrics::addSolverTime(triton::uint64 nanos) {
+    addSolverTime(nanos, lastPc);
+}
+
+
+/**
+ * Add time spent in the solver to an instruction.
+ * The instruction is only charged if the heat map is kept.
+ * @param nanos - Nanoseconds spent in the solver.
+ * @param pc - Address of the instruction.
+ */
+void Metrics::addSolverTime(triton::uint64 nanos, triton::uint64 pc) {
+    solverNanos.fetch_add(nanos, std::memory_order_relaxed);
+    if(!heatMap)
+        return;
+    std::lock_guard<std::mutex> guard(lock);
+    heat[pc].solverNanos += nanos;
+}
+
+
+/**
+ * Get a copy of the heat of every executed instruction.
+ * The copy is ordered by address, and may be taken while exploring.
+ * @return the heat of each instruction, keyed by address.
+ */
+std::map<triton::uint64, Metrics::Heat> Metrics::getHeatMap() {
+    std::lock_guard<std::mutex> guard(lock);
+    return std::map<triton::uint64, Heat>(heat.begin(), heat.end());
+}
+
+
+/**
+ * Add time spent in a hook.
+ * @param addr - Address of the hook.
+ * @param nanos - Nanoseconds spent in the hook.
+ */
+void Metrics::addHookTime(triton::uint64 addr, triton::uint64 nanos) {
+    std::lock_guard<std::mutex> guard(lock);
+    hookNanos[addr] += nanos;
+}
+
+
+/**
+ * Get a copy of the time spent in each hook.
+ * @return the nanoseconds spent in each hook, keyed by address.
+ */
+std::map<triton::uint64, triton::uint64> Metrics::getHookTimes() {
+    std::lock_guard<std::mutex> guard(lock);
+    return std::map<triton::uint64, triton::uint64>(hookNanos.begin(), hookNanos.end());
+}
+
+
+/**
+ * Get the name of a phase.
+ * @param p - Phase to name.
+ * @return the name of the phase.
+ */
+const char *Metrics::getPhaseName(Phase p) {
+    static const char *names[PHASES] = {
+        "idle", "fetch", "processing", "reinject", "hooks",
+        "stackAllocation", "stackReference", "memoryRead", "solver", "koi",
+    };
+    return p < PHASES ? names[p] : "";
+}
+
+
+/**
+ * Read the monotonic clock.
+ * @return nanoseconds since an arbitrary point.
+ */
+triton::uint64 Metrics::now() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+}
+
+
+/**
+ * Export the counters and heat map as JSON.
+ * Addresses are hexadecimal strings, since JSON numbers may not hold them.
+ * @return a JSON object of the metrics.
+ */
+std::string Metrics::toJson() {
+    std::stringstream ss;
+    ss << "{\"instructions\":" << instructions
+       << ",\"forks\":" << forks
+       << ",\"queries\":" << getQueries()
+       << ",\"sat\":" << sat
+       << ",\"unsat\":" << unsat
+       << ",\"timeout\":" << timeout
+       << ",\"outOfMemory\":" << outOfMemory
+       << ",\"unknown\":" << unknown
+       << ",\"solverNanos\":" << solverNanos
+       << ",\"cacheHits\":" << cacheHits
+       << ",\"symbolicVariables\":" << symbolicVariables
+       << ",\"heapAllocations\":" << heapAllocations
+       << ",\"hooksFired\":" << hooksFired
+       << ",\"prunedPaths\":" << prunedPaths
+       << ",\"phases\":{";
+    for(int p = Fetch; p < PHASES; p++)
+        ss << (p == Fetch ? "" : ",") << "\"" << getPhaseName((Phase)p) << "\":" << phaseNanos[p];
+
+    ss << "},\"hooks\":[";
+    bool first = true;
+    for(const auto& pair : getHookTimes()) {
+        ss << (first ? "" : ",")
+           << "{\"pc\":\"0x" << std::hex << pair.first << std::dec
+           << "\",\"nanos\":" << pair.second << "}";
+        first = false;
+    }
+
+    ss << "],\"heatMap\":[";
+
+    first = true;
+    for(const auto& pair : getHeatMap()) {
+        ss << (first ? "" : ",")
+           << "{\"pc\":\"0x" << std::hex << pair.first << std::dec
+           << "\",\"executions\":" << pair.second.executions
+           << ",\"solverNanos\":" << pair.second.solverNanos << "}";
+        first = false;
+    }
+    ss << "]}";
+    return ss.str();
+}
+
+
+/**
+ * Reset every counter and the heat map.
+ */
+void Metrics::clear() {
+    for(auto *counter : {&cacheHits, &forks, &heapAllocations, &hooksFired, &instructions, &outOfMemory,
+                         &prunedPaths, &sat, &solverNanos, &symbolicVariables, &timeout, &unknown, &unsat})
+        counter->store(0, std::memory_order_relaxed);
+    for(auto& counter : phaseNanos)
+        counter.store(0, std::memory_order_relaxed);
+    std::lock_guard<std::mutex> guard(lock);
+    heat.clear();
+    hookNanos.clear();
+    lastPc = 0;
+}
+
+
+/*********************/
+/* PRIVATE FUNCTIONS */
+/*********************/
+
+
+/**
+ * Switch to another phase, adding the time of the current one.
+ * Only the exploring thread switches phases, and idle time is not counted.
+ * @param p - Phase to switch to.
+ * @return the phase that was switched from.
+ */
+Metrics::Phase Metrics::__enter(Phase p) {
+    triton::uint64 t = now();
+    if(phase != Idle)
+        phaseNanos[phase].fetch_add(t - phaseStart, std::memory_order_relaxed);
+    Phase old = phase;
+    phase = p;
+    phaseStart = t;
+    return old;
+}
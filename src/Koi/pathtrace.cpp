@@ -0,0 +1,195 @@
+#include <cstring>
+#include <fstream>
+#include <triton/context.hpp>
+#include "Koi/pathtrace.h"
+
+
+/********************/
+/* HELPER FUNCTIONS */
+/********************/
+
+
+/**
+ * Write an integer to a trace, seven bits per byte.
+ * @param out - Stream to write to.
+ * @param v - Integer to write.
+ */
+static void putVarint(std::ostream& out, triton::uint64 v) {
+    while(v >= 0x80) {
+        out.put((char)(v | 0x80));
+        v >>= 7;
+    }
+    out.put((char)v);
+}
+
+
+/**
+ * Write the signed difference of two addresses to a trace.
+ * Nearby addresses take a byte or two, whichever way they differ.
+ * @param out - Stream to write to.
+ * @param prev - Previous address, updated to the next.
+ * @param next - Address to write.
+ */
+static void putDelta(std::ostream& out, triton::uint64& prev, triton::uint64 next) {
+    int64_t d = (int64_t)(next - prev);
+    putVarint(out, ((triton::uint64)d << 1) ^ (triton::uint64)(d >> 63));
+    prev = next;
+}
+
+
+/**
+ * Read an integer from a trace, seven bits per byte.
+ * @param in - Stream to read from.
+ * @param v - Where to store the integer.
+ * @return true if the integer was within the trace.
+ */
+static bool getVarint(std::istream& in, triton::uint64 *v) {
+    *v = 0;
+    for(uint shift = 0; shift < 64; shift += 7) {
+        int c = in.get();
+        if(c == EOF)
+            return false;
+        *v |= (triton::uint64)(c & 0x7f) << shift;
+        if(!(c & 0x80))
+            return true;
+    }
+    return false;
+}
+
+
+/**
+ * Read the signed difference of two addresses from a trace.
+ * @param in - Stream to read from.
+ * @param prev - Previous address, updated to the next.
+ * @return true if the difference was within the trace.
+ */
+static bool getDelta(std::istream& in, triton::uint64& prev) {
+    triton::uint64 z;
+    if(!getVarint(in, &z))
+        return false;
+    prev += (z >> 1) ^ -(z & 1);
+    return true;
+}
+
+
+/********************/
+/* PUBLIC FUNCTIONS */
+/********************/
+
+
+/**
+ * Append the path to a trace file.
+ * Addresses are written as differences from the one before, so a path of
+ * mostly sequential instructions takes about a byte per instruction.
+ * @param out - Stream of the trace file, after its magic number.
+ */
+void PathTrace::write(std::ostream& out) const {
+    putVarint(out, reason);
+    putVarint(out, endPc);
+    putVarint(out, pcs.size());
+    putVarint(out, branches.size());
+    putVarint(out, decisions.size());
+    putVarint(out, hooks.size());
+    putVarint(out, regions.size());
+
+    triton::uint64 prev = 0;
+    for(triton::uint64 pc : pcs)
+        putDelta(out, prev, pc);
+    prev = 0;
+    for(const auto& branch : branches) {
+        putDelta(out, prev, branch.first);
+        out.put(branch.second);
+    }
+    prev = 0;
+    for(const auto& decision : decisions) {
+        putDelta(out, prev, decision.first);
+        out.put(decision.second);
+    }
+    for(const HookCall& hook : hooks) {
+        putVarint(out, hook.pc);
+        putVarint(out, hook.dst);
+        putVarint(out, hook.ret);
+    }
+    for(const SymbolicRegion& region : regions) {
+        putVarint(out, region.ptr);
+        putVarint(out, region.len);
+        out.put(region.heap);
+    }
+}
+
+
+/**
+ * Read the next path of a trace file.
+ * @param in - Stream of the trace file, after its magic number.
+ * @return true if a whole path was read.
+ */
+bool PathTrace::read(std::istream& in) {
+    triton::uint64 r, nPcs, nBranches, nDecisions, nHooks, nRegions;
+    if(!getVarint(in, &r) || !getVarint(in, &endPc)
+    || !getVarint(in, &nPcs) || !getVarint(in, &nBranches) || !getVarint(in, &nDecisions)
+    || !getVarint(in, &nHooks) || !getVarint(in, &nRegions))
+        return false;
+    reason = r;
+
+    // Counts are not trusted to reserve memory, since the file may be truncated
+    pcs.clear();
+    branches.clear();
+    decisions.clear();
+    hooks.clear();
+    regions.clear();
+    triton::uint64 prev = 0;
+    for(triton::uint64 i = 0; i < nPcs; i++) {
+        if(!getDelta(in, prev))
+            return false;
+        pcs.push_back(prev);
+    }
+    prev = 0;
+    for(triton::uint64 i = 0; i < nBranches; i++) {
+        int jump;
+        if(!getDelta(in, prev) || (jump = in.get()) == EOF)
+            return false;
+        branches.push_back({prev, jump != 0});
+    }
+    prev = 0;
+    for(triton::uint64 i = 0; i < nDecisions; i++) {
+        int jump;
+        if(!getDelta(in, prev) || (jump = in.get()) == EOF)
+            return false;
+        decisions.push_back({prev, jump != 0});
+    }
+    for(triton::uint64 i = 0; i < nHooks; i++) {
+        HookCall hook;
+        if(!getVarint(in, &hook.pc) || !getVarint(in, &hook.dst) || !getVarint(in, &hook.ret))
+            return false;
+        hooks.push_back(hook);
+    }
+    for(triton::uint64 i = 0; i < nRegions; i++) {
+        SymbolicRegion region;
+        int heap;
+        if(!getVarint(in, &region.ptr) || !getVarint(in, &region.len) || (heap = in.get()) == EOF)
+            return false;
+        region.heap = heap != 0;
+        regions.push_back(region);
+    }
+    return true;
+}
+
+
+/**
+ * Read every path of a trace file.
+ * A path cut short by a truncated file is dropped.
+ * @param file - Path to the trace file.
+ * @return the paths of the file, empty if it is not a trace file.
+ */
+std::vector<PathTrace> PathTrace::load(const std::string& file) {
+    std::vector<PathTrace> paths;
+    std::ifstream in(file, std::ios::binary);
+    char magic[sizeof(MAGIC)];
+    if(!in.read(magic, sizeof(magic)) || memcmp(magic, MAGIC, sizeof(MAGIC)) != 0)
+        return paths;
+
+    PathTrace path;
+    while(path.read(in))
+        paths.push_back(path);
+    return paths;
+}
@@ -0,0 +1,130 @@
+#include <triton/context.hpp>
+#include "Koi/regionmap.h"
+
+
+/********************/
+/* PUBLIC FUNCTIONS */
+/********************/
+
+
+/**
+ * Add a region, replacing any regions it overlaps, or nesting a stack region within stack regions.
+ * A callee's frame may overlap its caller's, so the caller is set aside
+ * until the callee is erased, keeping what the callee does not cover.
+ * @param lo - First address of the region.
+ * @param hi - Last address of the region.
+ * @param kind - Kind of the region.
+ * @param tag - Identifier of the region within its kind.
+ * @param name - Name of the region (optional).
+ */
+void RegionMap::insert(triton::uint64 lo, triton::uint64 hi, RegionKind kind, triton::uint64 tag, const std::string& name) {
+    if(hi < lo)
+        return;
+
+    // Regions never overlap, so only the predecessor can reach into [lo, hi]
+    auto it = entries.lower_bound(lo);
+    if(it != entries.begin() && std::prev(it)->second.hi >= lo)
+        it--;
+    std::vector<Entry> hidden;
+    while(it != entries.end() && it->first <= hi) {
+        Entry e = it->second;
+        it = entries.erase(it);
+        if(kind != Stack || e.kind != Stack)
+            continue;
+        hidden.push_back(e);
+
+        // The parts outside of [lo, hi] stay visible
+        if(e.lo < lo) {
+            Entry below = e;
+            below.hi = lo - 1;
+            entries.emplace(below.lo, below);
+        }
+        if(e.hi > hi) {
+            Entry above = e;
+            above.lo = hi + 1;
+            entries.emplace(above.lo, above);
+        }
+    }
+    if(!hidden.empty())
+        nested[lo] = hidden;
+
+    Entry e;
+    e.lo = lo;
+    e.hi = hi;
+    e.kind = kind;
+    e.tag = tag;
+    e.name = name;
+    entries.emplace(lo, e);
+}
+
+
+/**
+ * Remove a region, restoring the stack regions it nested within.
+ * Nested regions are expected to be erased innermost first, as frames are.
+ * @param lo - First address of the region.
+ * @return true if the region existed.
+ */
+bool RegionMap::erase(triton::uint64 lo) {
+    auto it = entries.find(lo);
+    if(it == entries.end())
+        return false;
+    triton::uint64 hi = it->second.hi;
+    entries.erase(it);
+
+    // The visible parts of each region set aside are replaced by the whole
+    auto n = nested.find(lo);
+    if(n == nested.end())
+        return true;
+    for(const Entry& e : n->second) {
+        auto below = entries.find(e.lo);
+        if(e.lo < lo && below != entries.end() && below->second.kind == Stack && below->second.tag == e.tag)
+            entries.erase(below);
+        auto above = entries.find(hi + 1);
+        if(e.hi > hi && above != entries.end() && above->second.kind == Stack && above->second.tag == e.tag)
+            entries.erase(above);
+        entries[e.lo] = e;
+    }
+    nested.erase(n);
+    return true;
+}
+
+
+/**
+ * Remove every region of a kind.
+ * @param kind - Kind of the regions.
+ */
+void RegionMap::clear(RegionKind kind) {
+    if(kind == Stack)
+        nested.clear();
+    for(auto it = entries.begin(); it != entries.end();) {
+        if(it->second.kind == kind)
+            it = entries.erase(it);
+        else
+            it++;
+    }
+}
+
+
+/**
+ * Find the region containing an address.
+ * @param ptr - Address to classify.
+ * @return the region containing ptr, or nullptr if there is none.
+ */
+const RegionMap::Entry *RegionMap::find(triton::uint64 ptr) {
+    auto it = entries.upper_bound(ptr);
+    if(it == entries.begin())
+        return nullptr;
+    it--;
+    if(ptr > it->second.hi)
+        return nullptr;
+    return &it->second;
+}
+
+
+/**
+ * Get the number of regions.
+ * @return the number of regions.
+ */
+size_t RegionMap::size() {
+    return entries.size();
+}
@@ -0,0 +1,85 @@
+#include <algorithm>
+#include <triton/context.hpp>
+#include "Koi/shadowmemory.h"
+
+
+/********************/
+/* PUBLIC FUNCTIONS */
+/********************/
+
+/**
+ * Set the state of a range of memory.
+ * Pages that would only hold unallocated bytes are not created.
+ * @param ptr - Start of the memory range.
+ * @param len - Length of the memory range.
+ * @param state - New state of the bytes.
+ */
+void ShadowMemory::set(triton::uint64 ptr, size_t len, ShadowState state) {
+    while(len > 0) {
+        triton::uint64 page = ptr & ~(PAGE_SIZE - 1);
+        size_t offs = ptr - page;
+        size_t n = std::min(len, size_t(PAGE_SIZE - offs));
+
+        auto it = pages.find(page);
+        if(it == pages.end() && state != Unallocated)
+            it = pages.emplace(page, std::vector<triton::uint8>(PAGE_SIZE, Unallocated)).first;
+        if(it != pages.end())
+            std::fill(it->second.begin() + offs, it->second.begin() + offs + n, state);
+
+        ptr += n;
+        len -= n;
+    }
+}
+
+
+/**
+ * Get the state of a byte of memory.
+ * @param ptr - Address of the byte.
+ * @return the state of the byte.
+ */
+ShadowMemory::ShadowState ShadowMemory::get(triton::uint64 ptr) {
+    auto it = pages.find(ptr & ~(PAGE_SIZE - 1));
+    if(it == pages.end())
+        return Unallocated;
+    return ShadowState(it->second[ptr & (PAGE_SIZE - 1)]);
+}
+
+
+/**
+ * Find the first byte of a range in a poisoned state.
+ * @param ptr - Start of the memory range.
+ * @param len - Length of the memory range.
+ * @param poison - Bitmask of poisoned states, as (1 << state).
+ * @param bad - Where to store the address of the poisoned byte (optional).
+ * @return true if any byte in [ptr, ptr+len-1] is poisoned.
+ */
+bool ShadowMemory::check(triton::uint64 ptr, size_t len, triton::uint32 poison, triton::uint64 *bad) {
+    while(len > 0) {
+        triton::uint64 page = ptr & ~(PAGE_SIZE - 1);
+        size_t offs = ptr - page;
+        size_t n = std::min(len, size_t(PAGE_SIZE - offs));
+
+        // A missing page is entirely unallocated
+        auto it = pages.find(page);
+        for(size_t i = 0; i < n; i++) {
+            triton::uint8 state = it == pages.end() ? triton::uint8(Unallocated) : it->second[offs + i];
+            if(poison & (1 << state)) {
+                if(bad != nullptr)
+                    *bad = ptr + i;
+                return true;
+            }
+        }
+
+        ptr += n;
+        len -= n;
+    }
+    return false;
+}
+
+
+/**
+ * Forget the state of all memory.
+ */
+void ShadowMemory::clear() {
+    pages.clear();
+}
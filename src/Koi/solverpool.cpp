@@ -0,0 +1,326 @@
+#include <memory>
+#include <unordered_set>
+#include <triton/ast.hpp>
+#include <triton/context.hpp>
+#include "Koi/solverpool.h"
+
+
+/* Races a class must have before it is routed to a single solver */
+static const triton::uint64 ROUTE_MIN_RACES = 16;
+
+/* Every nth query of a routed class is still raced to keep learning */
+static const triton::uint64 ROUTE_SAMPLE = 8;
+
+/* Milliseconds a raced job may run without a limit, since the loser cannot be interrupted */
+static const triton::uint32 RACE_TIMEOUT = 30000;
+
+
+/********************/
+/* PUBLIC FUNCTIONS */
+/********************/
+
+
+/**
+ * Constructor
+ * @param n - Number of worker threads.
+ * @param kind - Solver for each worker to use.
+ * @return a new SolverPool
+ */
+SolverPool::SolverPool(uint n, triton::engines::solver::solver_e kind) {
+    // The portfolio partner is whichever of Z3 and Bitwuzla is not the default
+    // Triton only declares the solvers it was built with, so both must be
+    solvers[0] = kind;
+    solvers[1] = kind;
+#if defined(TRITON_Z3_INTERFACE) && defined(TRITON_BITWUZLA_INTERFACE)
+    solvers[1] = kind == triton::engines::solver::SOLVER_Z3
+               ? triton::engines::solver::SOLVER_BITWUZLA
+               : triton::engines::solver::SOLVER_Z3;
+    portfolioAvailable = true;
+#endif
+
+    for(uint i = 0; i < n; i++)
+        workers.emplace_back(&SolverPool::__work, this);
+}
+
+
+/**
+ * Destructor, waiting for running queries to finish.
+ * Queries that have not started are abandoned. A raced query is always
+ * time limited, so a losing solver never holds up the destructor forever.
+ * An abandoned query is answered as unknown once none of its jobs can
+ * answer it, so its future never holds a broken promise.
+ */
+SolverPool::~SolverPool() {
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        stopping = true;
+        for(Job& job : jobs) {
+            Query &query = *job.query;
+            query.jobs--;
+            if(!query.done && query.finished == query.jobs) {
+                Answer answer;
+                answer.status = triton::engines::solver::UNKNOWN;
+                query.done = true;
+                query.answer.set_value(answer);
+            }
+        }
+        jobs.clear();
+    }
+    wake.notify_all();
+    for(std::thread& worker : workers)
+        worker.join();
+}
+
+
+/**
+ * Queue a query for a model.
+ * Hard queries are raced by both solvers when the portfolio is enabled.
+ * The constraint is copied with its references unrolled before it is
+ * queued, so workers never read nodes the submitting thread may still
+ * change, such as when a variable is updated.
+ * @param node - Constraint to solve.
+ * @return a future answer for the constraint.
+ */
+std::future<SolverPool::Answer> SolverPool::submit(const triton::ast::SharedAbstractNode& node) {
+    auto query = std::make_shared<Query>();
+    query->node = triton::ast::newInstance(node.get(), true);
+    query->cls = 0;
+    auto result = query->answer.get_future();
+
+    // Without a portfolio, the default solver answers alone
+    if(!portfolio) {
+        __enqueue(query, 0, 0);
+        return result;
+    }
+
+    // Class the query by size
+    size_t nodes = countNodes(query->node, size_t(1) << (CLASSES - 1));
+    while((size_t(1) << (query->cls + 1)) <= nodes)
+        query->cls++;
+
+    // Learned classes go straight to their best solver
+    int route = __route(query->cls);
+    if(route >= 0)
+        __enqueue(query, route, 0);
+
+    // Large queries are raced immediately, others once they prove slow
+    else {
+        query->raced = true;
+        __enqueue(query, 0, 0);
+        __enqueue(query, 1, nodes >= portfolioNodes ? 0 : portfolioDelay);
+    }
+    return result;
+}
+
+
+/**
+ * Limit the resources of each query.
+ * @param ms - Milliseconds before a query times out, or 0 for no limit.
+ * @param mb - Megabytes a query may use, or 0 for no limit.
+ */
+void SolverPool::setLimits(triton::uint32 ms, triton::uint32 mb) {
+    std::lock_guard<std::mutex> guard(lock);
+    timeout = ms;
+    memoryLimit = mb;
+}
+
+
+/**
+ * Race both Z3 and Bitwuzla on hard queries.
+ * @param enabled - If the portfolio should be used.
+ * @param nodes - Number of AST nodes for a query to be raced immediately.
+ * @param delay - Milliseconds before a smaller query is raced.
+ * @return true if both solvers are available.
+ */
+bool SolverPool::setPortfolio(bool enabled, size_t nodes, uint delay) {
+    std::lock_guard<std::mutex> guard(lock);
+    portfolio = enabled && portfolioAvailable;
+    portfolioNodes = nodes;
+    portfolioDelay = delay;
+    return portfolioAvailable;
+}
+
+
+/**
+ * Get the number of races a solver has won for a class of query.
+ * @param cls - Class of the query.
+ * @param kind - Solver to query.
+ * @return the number of races won.
+ */
+triton::uint64 SolverPool::getWins(size_t cls, triton::engines::solver::solver_e kind) {
+    if(cls >= CLASSES)
+        return 0;
+    std::lock_guard<std::mutex> guard(lock);
+    for(uint i = 0; i < 2; i++) {
+        if(solvers[i] == kind)
+            return wins[cls][i];
+    }
+    return 0;
+}
+
+
+/**
+ * Get the number of worker threads.
+ * @return the number of worker threads.
+ */
+size_t SolverPool::size() {
+    return workers.size();
+}
+
+
+/**
+ * Count the distinct nodes of an AST, following references.
+ * @param node - Root of the AST.
+ * @param limit - Count at which to stop.
+ * @return the number of nodes, up to the limit.
+ */
+size_t SolverPool::countNodes(const triton::ast::SharedAbstractNode& node, size_t limit) {
+    std::unordered_set<triton::ast::AbstractNode*> seen;
+    std::vector<triton::ast::AbstractNode*> todo = {node.get()};
+    while(!todo.empty() && seen.size() < limit) {
+        triton::ast::AbstractNode *n = todo.back();
+        todo.pop_back();
+        if(n == nullptr || !seen.insert(n).second)
+            continue;
+        if(n->getType() == triton::ast::REFERENCE_NODE) {
+            auto *ref = static_cast<triton::ast::ReferenceNode*>(n);
+            todo.push_back(ref->getSymbolicExpression()->getAst().get());
+        }
+        for(const auto& child : n->getChildren())
+            todo.push_back(child.get());
+    }
+    return std::min(seen.size(), limit);
+}
+
+
+/*********************/
+/* PRIVATE FUNCTIONS */
+/*********************/
+
+
+/**
+ * Queue a job for a query, waking a worker.
+ * @param query - Query to attempt.
+ * @param solver - Index of the solver to attempt with.
+ * @param delay - Milliseconds before the job may start.
+ */
+void SolverPool::__enqueue(std::shared_ptr<Query> query, uint solver, uint delay) {
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        query->jobs++;
+        jobs.push_back({query, solver, std::chrono::steady_clock::now() + std::chrono::milliseconds(delay)});
+    }
+    wake.notify_one();
+}
+
+
+/**
+ * Attempt a query, answering it if no other job has yet.
+ * Triton cannot interrupt a solver, so a losing job runs to completion
+ * and its answer is discarded. Jobs of a raced query are therefore given
+ * a timeout even when queries have none. A job that has not started is
+ * skipped.
+ * A timeout or failure only answers the query once no other job can.
+ * @param job - Job to attempt.
+ * @param engines - The worker's solvers.
+ */
+void SolverPool::__solve(Job &job, triton::engines::solver::SolverEngine *engines) {
+    Query &query = *job.query;
+    triton::uint32 ms, mb;
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        if(query.done)
+            return;
+        query.started++;
+        ms = timeout;
+        mb = memoryLimit;
+        if(query.raced && ms == 0)
+            ms = RACE_TIMEOUT;
+    }
+
+    // Solve outside of the lock
+    Answer answer;
+    answer.status = triton::engines::solver::UNKNOWN;
+    auto start = std::chrono::steady_clock::now();
+    try {
+        engines[job.solver].setMemoryLimit(mb);
+        answer.model = engines[job.solver].getModel(query.node, &answer.status, ms);
+    } catch(const std::exception &e) {
+        answer.status = triton::engines::solver::UNKNOWN;
+    }
+    answer.nanos = std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count();
+
+    // The first decisive answer wins, else the last to finish
+    bool decisive = answer.status == triton::engines::solver::SAT || answer.status == triton::engines::solver::UNSAT;
+    std::lock_guard<std::mutex> guard(lock);
+    query.finished++;
+    if(query.done || (!decisive && query.finished < query.jobs))
+        return;
+    query.done = true;
+    if(query.started > 1 && decisive) {
+        races[query.cls]++;
+        wins[query.cls][job.solver]++;
+    }
+    query.answer.set_value(answer);
+}
+
+
+/**
+ * Get the solver that has won most races for a class of query.
+ * A class is routed once one solver wins three quarters of enough races.
+ * @param cls - Class of the query.
+ * @return the index of the preferred solver, or -1 if it should be raced.
+ */
+int SolverPool::__route(size_t cls) {
+    std::lock_guard<std::mutex> guard(lock);
+    if(races[cls] < ROUTE_MIN_RACES || races[cls] % ROUTE_SAMPLE == 0)
+        return -1;
+    for(int i = 0; i < 2; i++) {
+        if(wins[cls][i] * 4 >= races[cls] * 3)
+            return i;
+    }
+    return -1;
+}
+
+
+/**
+ * Run jobs until the pool is stopped.
+ * Each worker owns its solvers so that queries never share solver state.
+ */
+void SolverPool::__work() {
+    triton::engines::solver::SolverEngine engines[2];
+    engines[0].setSolver(solvers[0]);
+    if(portfolioAvailable)
+        engines[1].setSolver(solvers[1]);
+
+    while(true) {
+        Job job;
+        {
+            std::unique_lock<std::mutex> guard(lock);
+            while(true) {
+                if(stopping)
+                    return;
+
+                // Take the oldest job that may start, noting when the next may
+                auto now = std::chrono::steady_clock::now();
+                auto next = std::chrono::steady_clock::time_point::max();
+                auto it = jobs.begin();
+                for(; it != jobs.end(); it++) {
+                    if(it->notBefore <= now)
+                        break;
+                    next = std::min(next, it->notBefore);
+                }
+                if(it != jobs.end()) {
+                    job = *it;
+                    jobs.erase(it);
+                    break;
+                }
+                if(next == std::chrono::steady_clock::time_point::max())
+                    wake.wait(guard);
+                else
+                    wake.wait_until(guard, next);
+            }
+        }
+        __solve(job, engines);
+    }
+}
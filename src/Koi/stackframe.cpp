@@ -1,3 +1,4 @@
+#include <algorithm>
 #include <triton/context.hpp>
 #include "Koi/stackframe.h"
 
@@ -12,6 +13,7 @@
  */
 Stackframe::Stackframe() : Cove() {
     accesses = {};
+    layoutValid = false;
 }
 
 
@@ -23,6 +25,7 @@ Stackframe::Stackframe() : Cove() {
  */
 Stackframe::Stackframe(triton::uint64 a, size_t s) : Cove(a, s) {
     accesses = {0, s};
+    layoutValid = false;
 }
 
 
@@ -32,28 +35,56 @@ Stackframe::Stackframe(triton::uint64 a, size_t s) : Cove(a, s) {
  * @return true if the access is new
  */
 bool Stackframe::addAccess(triton::uint64 offs) {
-    auto it = std::find(accesses.begin(), accesses.end(), offs);
-    if(it == accesses.end()) {
-        accesses.push_back(offs);
-        std::sort(accesses.begin(), accesses.end());
-        return true;
-    }
-    return false;
+    // Accesses are kept sorted, so insert in place
+    auto it = std::lower_bound(accesses.begin(), accesses.end(), offs);
+    if(it != accesses.end() && *it == offs)
+        return false;
+    accesses.insert(it, offs);
+    layoutValid = false;
+    return true;
+}
+
+
+/**
+ * Remove an access offset from a Stackframe
+ * @param offs - Offset of the access.
+ */
+void Stackframe::removeAccess(triton::uint64 offs) {
+    auto it = std::lower_bound(accesses.begin(), accesses.end(), offs);
+    if(it == accesses.end() || *it != offs)
+        return;
+    accesses.erase(it);
+    layoutValid = false;
 }
 
 
 /**
  * Get the length until the next access or end of stack.
+ * Offsets count down from the base, so the next access towards the base
+ * is the nearest one at a smaller offset.
  * @param offs - Offset to start search from.
  * @return the length until the next access.
  */
 size_t Stackframe::getAccessGap(triton::uint64 offs) {
-    // Finds a gap until next access
-    for(size_t i = 1; i < accesses.size(); i++) {
-        if(offs >= accesses[i])
-            return offs - accesses[i-1];
+    auto it = std::lower_bound(accesses.begin(), accesses.end(), offs);
+    if(it == accesses.begin())
+        return 0;
+    return offs - *std::prev(it);
+}
+
+
+/**
+ * Get the layout of the stackframe, cached until the next new access.
+ * @return the slots of the stackframe in order of offset.
+ */
+const std::vector<Stackframe::Slot>& Stackframe::getLayout() {
+    if(!layoutValid) {
+        layout.clear();
+        for(size_t i = 1; i < accesses.size(); i++)
+            layout.push_back({accesses[i], size_t(accesses[i] - accesses[i-1])});
+        layoutValid = true;
     }
-    return 0;
+    return layout;
 }
 
 
@@ -66,6 +97,7 @@ void Stackframe::update(triton::uint64 a, size_t s) {
     addr = a;
     sz = s;
     accesses = {0, s};
+    layoutValid = false;
 }
 
 
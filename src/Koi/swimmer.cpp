@@ -1,13 +1,19 @@
+#include <algorithm>
+#include <chrono>
+#include <elf.h>
 #include <fstream>
 #include <iomanip>
 #include <iostream>
+#include <memory>
 #include <optional>
 #include <sstream>
+#include <unordered_set>
 #include <vector>
 #include <triton/context.hpp>
 #include <triton/x86Specifications.hpp>
 #include <triton/ast.hpp>
 #include "Koi/buffer.h"
+#include "Koi/solverpool.h"
 #include "Koi/stackframe.h"
 #include "Koi/swimmer.h"
 #include "elfivator.h"
@@ -45,66 +51,98 @@ std::vector<triton::ast::SharedAbstractNode> getIte(triton::arch::Instruction in
 /**
  * Constructor
  * @param filein - Path to a file to load.
+ * @param mode - Load the file by its sections or PT_LOAD segments (default=Sections).
+ * @param base - Address to load a position independent file at (default=0x100000).
  * @return a new Swimmer
  */
-Swimmer::Swimmer(const std::string& filein) : triton::Context(triton::arch::ARCH_X86_64) {
-    // Registers with assumed starting values
-    // TODO: This should be handled by the loader
-    setConcreteRegisterValue(registers.x86_rip, 0);
-    setConcreteRegisterValue(registers.x86_rbp, STACK_START);
-    setConcreteRegisterValue(registers.x86_rsp, STACK_START);
-
-    // General-use registers
-    symbolizeRegister(registers.x86_rax, "symbolic_rax");
-    symbolizeRegister(registers.x86_rbx, "symbolic_rbx");
-    symbolizeRegister(registers.x86_rcx, "symbolic_rcx");
-    symbolizeRegister(registers.x86_rdx, "symbolic_rdx");
-    symbolizeRegister(registers.x86_rsi, "symbolic_rsi");
-    symbolizeRegister(registers.x86_rdi, "symbolic_rdi");
-    symbolizeRegister(registers.x86_r8, "symbolic_r8");
-    symbolizeRegister(registers.x86_r9, "symbolic_r9");
-    symbolizeRegister(registers.x86_r10, "symbolic_r10");
-    symbolizeRegister(registers.x86_r11, "symbolic_r11");
-    symbolizeRegister(registers.x86_r12, "symbolic_r12");
-    symbolizeRegister(registers.x86_r13, "symbolic_r13");
-    symbolizeRegister(registers.x86_r14, "symbolic_r14");
-    symbolizeRegister(registers.x86_r15, "symbolic_r15");
-
-    // Common flag registers
-    symbolizeRegister(registers.x86_cf, "symbolic_cf");
-    symbolizeRegister(registers.x86_of, "symbolic_of");
-    symbolizeRegister(registers.x86_pf, "symbolic_pf");
-    symbolizeRegister(registers.x86_sf, "symbolic_sf");
-    symbolizeRegister(registers.x86_tf, "symbolic_tf");
-    symbolizeRegister(registers.x86_zf, "symbolic_zf");
-
-    // XMM registers
-    symbolizeRegister(registers.x86_xmm0, "symbolic_xmm0");
-    symbolizeRegister(registers.x86_xmm1, "symbolic_xmm1");
-    symbolizeRegister(registers.x86_xmm2, "symbolic_xmm2");
-    symbolizeRegister(registers.x86_xmm3, "symbolic_xmm3");
-    symbolizeRegister(registers.x86_xmm4, "symbolic_xmm4");
-    symbolizeRegister(registers.x86_xmm5, "symbolic_xmm5");
-    symbolizeRegister(registers.x86_xmm6, "symbolic_xmm6");
-    symbolizeRegister(registers.x86_xmm7, "symbolic_xmm7");
-    symbolizeRegister(registers.x86_xmm8, "symbolic_xmm8");
-    symbolizeRegister(registers.x86_xmm9, "symbolic_xmm9");
-    symbolizeRegister(registers.x86_xmm10, "symbolic_xmm10");
-    symbolizeRegister(registers.x86_xmm11, "symbolic_xmm11");
-    symbolizeRegister(registers.x86_xmm12, "symbolic_xmm12");
-    symbolizeRegister(registers.x86_xmm13, "symbolic_xmm13");
-    symbolizeRegister(registers.x86_xmm14, "symbolic_xmm14");
-    symbolizeRegister(registers.x86_xmm15, "symbolic_xmm15");
+Swimmer::Swimmer(const std::string& filein, LoadMode mode, triton::uint64 base) : triton::Context(triton::arch::ARCH_X86_64) {
+    // Set up the registers and call stack
+    __initState();
+
+    // Load the bytes using Elfivator, read from an image shared by every Swimmer of the file
+    image = Elfivator::share(filein, snapshotDir);
+    if(image.use_count() > 1)
+        metrics.cacheHits++;
+    loadMode = mode;
+    __loadImage(base);
+}
 
-    // Initialize the stackframe as not existing
-    stackframes.push_back(Stackframe(STACK_START, 0));
 
-    // Load the bytes using Elfivator
-    Elfivator e = Elfivator(filein);
-    for(auto& section : e.sections) {
-        if(section.name != ".plt.sec")
-            setConcreteMemoryAreaValue(section.offset + 0x100000, section.data);
+/**
+ * Return to the state right after loading, so the Swimmer can run another job.
+ * Constraints, symbolic state, registers, heap, stackframes and written
+ * memory are forgotten, and the image is copied in again as it is read.
+ * Hooks, injections and settings are kept unless asked otherwise.
+ * @param unhook - If true, also remove hooks, watchpoints, injections and dead ends (default=false).
+ */
+void Swimmer::reset(bool unhook) {
+    // Drop queries about the old symbolic state, restarting the pool on the next exploration
+    speculations.clear();
+    solverPool.reset();
+
+    // Forget the symbolic and concrete state, keeping callbacks and modes
+    concretizeAllMemory();
+    concretizeAllRegister();
+    clearPathConstraints();
+    getCpuInstance()->clear();
+
+    // Forget the exploration
+    cnstrs.clear();
+    branches.clear();
+    decisions.clear();
+    forks.clear();
+    deferred.clear();
+    pendingTargets.clear();
+    targetModels.clear();
+    trace = PathTrace();
+    visits.clear();
+    exploreTarget = 0;
+    exploreMaxVisits = 0;
+    exploreMaxDepth = 0;
+    exploring = false;
+    backtracks = 0;
+    depth = 0;
+    fid = 0;
+    pathFid = 0;
+    astConcretizations = 0;
+    solverStats = SolverStats();
+
+    // The image is not loaded again, so its cache hit still counts
+    triton::uint64 hits = metrics.cacheHits;
+    metrics.clear();
+    metrics.cacheHits = hits;
+
+    // Forget the memory made on every path
+    heapAllocations.clear();
+    heapChunks.clear();
+    heapFree.clear();
+    heapQuarantine.clear();
+    heapQuarantined = 0;
+    heapTop = HEAP_START;
+    lazyRegions.clear();
+    regions.clear();
+    regionMap.clear(RegionMap::Heap);
+    regionMap.clear(RegionMap::Stack);
+    shadow.clear();
+    frameJournal.clear();
+    stackframes.clear();
+
+    // Forget the hooks too, if asked to
+    if(unhook) {
+        accessHooks.clear();
+        deadEnds.clear();
+        funcHooks.clear();
+        injectedInstructions.clear();
+        insnHooks.clear();
+        pathHooks.clear();
+        watchpoints.clear();
+        watchedPages.clear();
+        watchedFar = false;
     }
+
+    // Set up as if newly loaded
+    __initState();
+    __armPages();
 }
 
 
@@ -125,172 +163,151 @@ void Swimmer::setPc(triton::uint64 x) {
  * @return if the target was reached (default=False)
  */
 bool Swimmer::explore(triton::uint64 target, uint maxVisits, uint maxDepth) {
-    uint localFid = fid;
-    depth++;
-    fid++;
-
-    // Iterate until one of many stopping conditions
-    while(true) {
-        // Get the instruction pointer
-        triton::uint64 pc = triton::uint64(getConcreteRegisterValue(registers.x86_rip));
-
-        // Ensure the instruction has not been visited too many times
-        if(maxVisits > 0) {
-            if(++visits[pc] > maxVisits) {
-                if(verbosity & SV_STOPS)
-                    std::cout << "\033[31mExhausted 0x" << std::setfill('0') << std::hex << pc << "\033[0m" << std::dec << std::endl;
-                break;
-            }
-        }
-
-        // Get the instruction bytes if they have been defined
-        if(!isConcreteMemoryValueDefined(pc, 1)) {
-            if(verbosity & SV_STOPS)
-                std::cout << "\033[31mUndefined: 0x" << std::hex << pc << "\033[0m" << std::dec << std::endl;
-            break;
-        }
-        std::vector<triton::uint8> opcode = getConcreteMemoryAreaValue(pc, 16);
-
-        // Initialize the next instruction
-        triton::arch::Instruction insn = injectedInstructions.count(pc)
-                                       ? injectedInstructions[pc]
-                                       : triton::arch::Instruction(pc, opcode.data(), 16);
-
-        // Process the instruction
-        processing(insn);
-        triton::uint32 insnType = insn.getType();
-        if(verbosity & SV_INSN)
-            std::cout << "[" << localFid << "] (" << depth << ") " << insn << std::endl;
-        if(verbosity & SV_REGS)
-            __printRegisters();
-
-        // Restore semantics of an injected instruction
-        if(injectedInstructions.count(pc)) {
-            insn.symbolicExpressions = injectedInstructions[pc].symbolicExpressions;
-            disassembly(insn);
-        }
-
-        // Perform address/instruction hooks
-        if(insnHooks.count(pc)) {
-            for(InsnHook& callback : insnHooks[pc]) {
-                callback(this, insn);
-            }
-        }
-
-        // Return success if target is reached
-        if(target != 0 & pc == target) {
-            if(verbosity & SV_STOPS)
-                std::cout << "\033[32mTarget Reached\033[0m" << std::endl;
-            return true;
-        }
+    beginExplore(target, maxVisits, maxDepth);
+
+    // Step without an instruction limit until the search is over
+    StepResult result;
+    do {
+        result = step(0);
+    } while(result == Paused || result == Forked);
+    return result == Succeeded;
+}
 
-        // Return failure if dead end is reached
-        if(std::find(deadEnds.begin(), deadEnds.end(), pc) != deadEnds.end()) {
-            if(verbosity & SV_STOPS)
-                std::cout << "\033[31mDead End Reached\033[0m" << std::endl;
-            return false;
-        }
 
-        // Handle stackframe information
-        // This idoes not disqualify other handlers
-        __handleStackAllocation(insn);
-        __handleStackReference(insn);
+/**
+ * Prepare a step-wise exploration from the instruction pointer
+ * @param target - Desired address to execute
+ * @param maxVisits - Maximum number of times to execute the same instruction
+ * @param maxDepth - Maximum fork depth of an execution branch
+ */
+void Swimmer::beginExplore(triton::uint64 target, uint maxVisits, uint maxDepth) {
+    exploreTarget = target;
+    exploreMaxVisits = maxVisits;
+    exploreMaxDepth = maxDepth;
+    forks.clear();
+    speculations.clear();
+    deferred.clear();
+    backtracks = 0;
+    pathFid = fid++;
+    depth = 1;
+    exploring = true;
+    resuming = false;
+    trace = PathTrace();
+
+    // Deferrals are resumed from the state the exploration began in
+    entry.pc = triton::uint64(getConcreteRegisterValue(registers.x86_rip));
+    entry.rbp = triton::uint64(getConcreteRegisterValue(registers.x86_rbp));
+    entry.rsp = triton::uint64(getConcreteRegisterValue(registers.x86_rsp));
+    entry.nBranches = branches.size();
+    entry.nCnstrs = cnstrs.size();
+    entry.nDecisions = decisions.size();
+    entry.nFrames = frameJournal.size();
+    entry.nRegions = regions.size();
+
+    // Solver workers are only started when asked for
+    if(solverThreads == 0)
+        solverPool.reset();
+    else if(!solverPool || solverPool->size() != solverThreads)
+        solverPool = std::make_unique<SolverPool>(solverThreads, getSolver());
+    if(solverPool)
+        solverPool->setLimits(solverTimeout, solverMemoryLimit);
+    if(solverPool && !solverPool->setPortfolio(solverPortfolio, portfolioNodes, portfolioDelay) && solverPortfolio && (verbosity & SV_BRANCH))
+        std::cout << "\033[33mSolver Portfolio Unavailable\033[0m" << std::endl;
+}
 
-        // Break on halt
-        if(insnType == triton::arch::x86::ID_INS_HLT)
-            break;
 
-        // Break on return when the next instruction is fallthrough
-        else if(insnType == triton::arch::x86::ID_INS_RET) {
-            if(getConcreteRegisterValue(registers.x86_rip) == 0) {
-                std::cout << "\033[31mEnd of Path Reached\033[0m" << std::endl;
-                break;
-            } else if (verbosity & SV_STACK) {
-                stackframes.pop_back();
-                std::cout << "\033[1mEnd of stackframe\033[0m" << std::endl;
-            }
+/**
+ * Continue a step-wise exploration
+ * @param n - Maximum number of instructions to execute, or 0 for no limit (default=1)
+ * @return the state of the exploration when control is returned
+ */
+Swimmer::StepResult Swimmer::step(uint n) {
+    if(!exploring)
+        return Finished;
+
+    // Return early on a fork or the end of the search
+    // Traced records are written before control is returned
+    for(uint i = 0; n == 0 || i < n; i++) {
+        StepResult result = __step();
+        if(result != Paused) {
+            __flushTrace();
+            return result;
         }
+    }
+    __flushTrace();
+    return Paused;
+}
 
-        // Handle calls to unknown memory by skipping or hooking
-        else if(__handleCall(localFid, pc, insn))
-            continue;
-
-        // Check for new symbolic stack variables
-        else if(__handleMemoryRead(pc, insn))
-            continue;
-
-        // Fork at symbolic conditional branch
-        else if(insn.isBranch() && insn.isSymbolized() && insnType != triton::arch::x86::ID_INS_JMP) {
-            // Forking is only possible if an instruction is symbolized
-            std::vector<triton::ast::SharedAbstractNode> ite = getIte(insn);
-
-            // The symbolic statement was found
-            if(ite.size() == 3) {
-                triton::ast::SharedAstContext astCtxt = getAstContext();
-
-                // Determine satisfiable model for "if"
-                cnstrs.push_back(ite[0]);
-                triton::ast::SharedAbstractNode cnstr_if = cnstrs.size() > 1 ? astCtxt->land(cnstrs) : cnstrs[0];
-                std::unordered_map<long unsigned int, triton::engines::solver::SolverModel> model_if = getModel(cnstr_if);
-                cnstrs.pop_back();
-
-                // Determine satisfiable model for "else"
-                cnstrs.push_back(astCtxt->lnot(ite[0]));
-                triton::ast::SharedAbstractNode cnstr_else = cnstrs.size() > 1 ? astCtxt->land(cnstrs) : cnstrs[0];
-                std::unordered_map<long unsigned int, triton::engines::solver::SolverModel> model_else = getModel(cnstr_else);
-                cnstrs.pop_back();
-
-                // Only fork if both satisfiable, else defer to Triton
-                if(model_if.size() > 0 && model_else.size() > 0) {
-                    // Verify exection depth is not too complex
-                    if(maxDepth > 0 && depth >= maxDepth) {
-                        if(verbosity & SV_STOPS)
-                            std::cout << "\033[31mToo deep to fork\033[0m" << std::endl;
-                        continue;
-                    }
 
-                    // Recursively follow the jump
-                    else {
-                        setConcreteRegisterValue(registers.x86_rip, ite[1]->evaluate());
-                        cnstrs.push_back(cnstr_if);
-                        if(verbosity & SV_BRANCH)
-                            std::cout << "\033[1mJUMP from 0x" << std::hex << pc << std::dec << "\033[0m" << std::endl;
-                        if(verbosity & SV_MODEL) {
-                            for (const auto& pair : model_if) {
-                                std::cout << "\t" << pair.first << ": "<< pair.second << std::endl;
-                            }
-                        }
-
-                        // TODO: Save and restore all registers, not just RBP
-                        // TODO: This will need to be done for memory as well
-                        triton::uint64 rbpBefore = triton::uint64(getConcreteRegisterValue(registers.x86_rbp));
-                        if(explore(target, maxVisits, maxDepth))
-                            return true;
-                        cnstrs.pop_back();
-                        setConcreteRegisterValue(registers.x86_rbp, rbpBefore);
-
-                        // Restore to fallthrough
-                        if(verbosity & SV_BRANCH)
-                            std::cout << "\033[1mFALL from 0x" << std::hex << pc << std::dec << "\033[0m" << std::endl;
-                        if(verbosity & SV_MODEL) {
-                            for (const auto& pair : model_else) {
-                                std::cout << "\t" << pair.first << ": "<< pair.second << std::endl;
-                            }
-                        }
-                    }
-                    setConcreteRegisterValue(registers.x86_rip, ite[2]->evaluate());
-                    cnstrs.push_back(cnstr_else);
+/**
+ * Explores the memory pool once for several targets, recording a model for each
+ * @param targets - Desired addresses to execute
+ * @param maxVisits - Maximum number of times to execute the same instruction
+ * @param maxDepth - Maximum fork depth of an execution branch
+ * @return a model for each target that was reached, keyed by target
+ */
+std::unordered_map<triton::uint64, std::unordered_map<long unsigned int, triton::engines::solver::SolverModel>> Swimmer::exploreTargets(const std::vector<triton::uint64>& targets, uint maxVisits, uint maxDepth) {
+    // Targets are removed from the pending set as they are reached
+    pendingTargets = std::unordered_set<triton::uint64>(targets.begin(), targets.end());
+    pendingTargets.erase(0);
+    targetModels.clear();
+
+    // Exploration without a single target stops once nothing is pending
+    if(!pendingTargets.empty())
+        explore(0, maxVisits, maxDepth);
+    pendingTargets.clear();
+
+    // Hand the models to the caller
+    std::unordered_map<triton::uint64, std::unordered_map<long unsigned int, triton::engines::solver::SolverModel>> models;
+    models.swap(targetModels);
+    return models;
+}
 
-                } // sat && sat
 
-            } // found ite
+/**
+ * Record every path explored from now on to a trace file.
+ * Each path is appended once it terminates, before the next is explored.
+ * @param file - Path to the trace file, or empty to stop recording.
+ * @return true if the trace file was created, or recording stopped.
+ */
+bool Swimmer::recordPaths(const std::string& file) {
+    if(recording.is_open())
+        recording.close();
+    if(file.empty())
+        return true;
 
-        } // is symbolic branch
+    recording.open(file, std::ios::binary | std::ios::trunc);
+    if(!recording)
+        return false;
+    recording.write(PathTrace::MAGIC, sizeof(PathTrace::MAGIC));
+    return true;
+}
 
-    } // exploration loop
 
-    depth--;
-    return false;
+/**
+ * Follow a recorded path from the instruction pointer without the solver.
+ * Each symbolic branch takes its recorded side, so no model is needed to
+ * reach the end of the path. Hooks are called as they would be exploring,
+ * so they symbolize the same regions, and each must return what it did.
+ * @param path - Recorded path to follow.
+ * @param maxVisits - Maximum number of times to execute the same instruction (default=0).
+ * @return true if every recorded branch and hook call was followed, and the same regions were symbolized.
+ */
+bool Swimmer::replay(const PathTrace& path, uint maxVisits) {
+    replayPath = path;
+    replayDiverged = false;
+    replayHook = 0;
+    replayNext = 0;
+    replaying = true;
+    beginExplore(path.reason == Target ? path.endPc : 0, maxVisits, 0);
+
+    // A replayed path never forks, so it runs until it ends
+    StepResult result;
+    do {
+        result = step(0);
+    } while(result == Paused || result == Forked);
+    replaying = false;
+    return !replayDiverged && replayNext == replayPath.branches.size() && replayHook == replayPath.hooks.size();
 }
 
 
@@ -318,6 +335,83 @@ void Swimmer::hookFunction(triton::uint64 addr, FuncHook callback) {
 }
 
 
+/**
+ * Add a hook to a function by name, such as an import through the PLT.
+ * @param name - Name of the function.
+ * @param callback - FuncHook to call after instead of the function.
+ * @return true if the name was resolved and hooked.
+ */
+bool Swimmer::hookFunction(const std::string& name, FuncHook callback) {
+    triton::uint64 addr = getSymbolAddress(name);
+    if(addr == 0)
+        return false;
+    hookFunction(addr, callback);
+    return true;
+}
+
+
+/**
+ * Add a hook to the end of every explored path.
+ * @param callback - PathHook to call when a path terminates.
+ */
+void Swimmer::hookPath(PathHook callback) {
+    pathHooks.push_back(callback);
+}
+
+
+/**
+ * Add a hook to memory accesses that violate the shadow memory.
+ * Accesses are only checked when checkAccesses is set.
+ * @param callback - AccessHook to call after processing the accessing instruction.
+ */
+void Swimmer::hookAccess(AccessHook callback) {
+    accessHooks.push_back(callback);
+}
+
+
+/**
+ * Add a hook to reads and/or writes of an address range.
+ * @param lo - First address of the range.
+ * @param hi - Last address of the range.
+ * @param callback - WatchHook to call after processing the accessing instruction.
+ * @param read - If true, reads of the range call the hook (default=true).
+ * @param write - If true, writes to the range call the hook (default=true).
+ */
+void Swimmer::watchMemory(triton::uint64 lo, triton::uint64 hi, WatchHook callback, bool read, bool write) {
+    if(hi < lo || (!read && !write))
+        return;
+    Watchpoint w;
+    w.lo = lo;
+    w.hi = hi;
+    w.callback = callback;
+    w.read = read;
+    w.write = write;
+    watchpoints.push_back(w);
+    __markWatched(lo, hi);
+}
+
+
+/**
+ * Remove the watchpoints of an address range.
+ * @param lo - First address of the range.
+ * @param hi - Last address of the range.
+ * @return the number of watchpoints removed.
+ */
+size_t Swimmer::unwatchMemory(triton::uint64 lo, triton::uint64 hi) {
+    size_t n = watchpoints.size();
+    watchpoints.erase(std::remove_if(watchpoints.begin(), watchpoints.end(), [&](const Watchpoint& w) {
+        return w.lo == lo && w.hi == hi;
+    }), watchpoints.end());
+
+    // Rebuild the bitmap from the remaining watchpoints
+    watchedPages.clear();
+    watchedFar = false;
+    for(const Watchpoint& w : watchpoints)
+        __markWatched(w.lo, w.hi);
+    return n - watchpoints.size();
+}
+
+
 /**
  * Mark an address as dead, stopping execution if it is reached.
  * @param addr - Dead address
@@ -371,6 +465,38 @@ bool Swimmer::injectJumpCondition(triton::uint64 addr, triton::ast::SharedAbstra
 }
 
 
+/**
+ * Creates a model for a constraint within the solver limits.
+ * @param node - Constraint to solve.
+ * @param status - Where to store the status of the query (optional).
+ * @return a model for the constraint, empty if not found.
+ */
+std::unordered_map<long unsigned int, triton::engines::solver::SolverModel> Swimmer::getModel(const triton::ast::SharedAbstractNode& node, triton::engines::solver::status_e *status) {
+    return __solve(node, status, solverTimeout);
+}
+
+
+/**
+ * Creates several models for a constraint within the solver limits.
+ * @param node - Constraint to solve.
+ * @param limit - The number of models to return
+ * @param status - Where to store the status of the query (optional).
+ * @return a vector of models for the constraint
+ */
+std::vector<std::unordered_map<long unsigned int, triton::engines::solver::SolverModel>> Swimmer::getModels(const triton::ast::SharedAbstractNode& node, uint limit, triton::engines::solver::status_e *status) {
+    triton::engines::solver::status_e result = triton::engines::solver::UNKNOWN;
+    setSolverMemoryLimit(solverMemoryLimit);
+    Metrics::Timer timer(__timing(), Metrics::Solver);
+    auto start = std::chrono::steady_clock::now();
+    auto models = triton::Context::getModels(node, limit, &result, solverTimeout);
+    metrics.addSolverTime(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+    __countOutcome(result);
+    if(status != nullptr)
+        *status = result;
+    return models;
+}
+
+
 /**
  * Creates a model for the current constraints.
  * @return a model for the current constraints.
@@ -398,47 +524,175 @@ std::vector<std::unordered_map<long unsigned int, triton::engines::solver::Solve
 }
 
 
+/**
+ * Drop symbolic expressions that no longer depend on any variable.
+ * The concrete value of such an expression is already known, so memory and
+ * registers holding one are concretized to let Triton free the expression.
+ * @return the number of memory bytes and registers concretized.
+ */
+size_t Swimmer::compact() {
+    size_t n = 0;
+    for(const auto& pair : getSymbolicMemory()) {
+        if(!pair.second->getAst()->isSymbolized()) {
+            concretizeMemory(pair.first);
+            n++;
+        }
+    }
+    for(const auto& pair : getSymbolicRegisters()) {
+        if(!pair.second->getAst()->isSymbolized()) {
+            concretizeRegister(getRegister(pair.first));
+            n++;
+        }
+    }
+    if(verbosity & SV_MEM)
+        __trace(TraceSink::Compacted, n);
+    return n;
+}
+
+
+/**
+ * Symbolize lazy memory that has not been written or read yet.
+ * Symbolizing a byte reads it, which calls back into here, so nested
+ * calls do nothing.
+ * @param ptr - Starting address of the memory.
+ * @param len - Length of the memory.
+ */
+void Swimmer::materializeMemory(triton::uint64 ptr, size_t len) {
+    if(materializing || lazyRegions.empty())
+        return;
+    materializing = true;
+    for(size_t i = 0; i < len; i++) {
+        triton::uint64 addr = ptr + i;
+        auto it = lazyRegions.upper_bound(addr);
+        if(it == lazyRegions.begin())
+            continue;
+        it--;
+        if(addr >= it->first + it->second.len)
+            continue;
+
+        // Only bytes that are still untouched are symbolized
+        triton::arch::MemoryAccess mem = triton::arch::MemoryAccess(addr, 1);
+        if(isConcreteMemoryValueDefined(mem) || isMemorySymbolized(mem))
+            continue;
+
+        // Name the byte as if it had been symbolized eagerly
+        std::stringstream ss;
+        if(it->second.stack) {
+            triton::uint64 base = it->first + it->second.len - 1;
+            ss << it->second.name << "[-0x" << std::hex << (base - addr) << std::dec << "]";
+            symbolizeMemory(mem, ss.str());
+            metrics.symbolicVariables++;
+        }
+        else {
+            ss << it->second.name << "[0x" << (addr - it->first) << "]";
+            auto var = symbolizeMemory(mem, ss.str());
+            metrics.symbolicVariables++;
+
+            // Variables are kept by offset, since bytes are read in any order
+            auto chunk = heapAllocations.find(it->first);
+            if(chunk != heapAllocations.end()) {
+                Buffer& b = chunk->second;
+                size_t v = (addr - it->first) / b.getGranularity();
+                if(b.vars.size() < it->second.len / b.getGranularity())
+                    b.vars.resize(it->second.len / b.getGranularity());
+                if(v < b.vars.size())
+                    b.vars[v] = var;
+            }
+        }
+        clearConcreteMemoryValue(mem);
+    }
+    materializing = false;
+}
+
+
 /**
  * Reads a string from memory
+ * The string ends at the first byte that is not defined. Bytes are read
+ * without callbacks, so lazy memory is not symbolized by reading it.
  * @param ptr - Address in memory to read from.
  * @return the string stored in memory (if defined).
  */
 std::string Swimmer::readString(triton::uint64 ptr) {
     std::stringstream ss;
-    unsigned char c = getConcreteMemoryAreaValue(ptr, 1)[0];
-    while(c != '\0') {
-        if(!isConcreteMemoryValueDefined(ptr))
+    while(isConcreteMemoryValueDefined(ptr)) {
+        unsigned char c = getConcreteMemoryValue(ptr, false);
+        if(c == '\0')
             break;
         ss << c;
         ptr++;
-        c = getConcreteMemoryValue(ptr);
     }
     return ss.str();
 }
 
 
+/**
+ * Get the address of an imported or defined function.
+ * Imports resolve to their PLT stub, which is where calls to them land.
+ * @param name - Name of the function.
+ * @return the address of the function's PLT stub or body, or 0 if unknown.
+ */
+triton::uint64 Swimmer::getSymbolAddress(const std::string& name) {
+    auto it = image->imports.find(name);
+    if(it != image->imports.end())
+        return loadBias + it->second;
+    it = image->symbols.find(name);
+    if(it != image->symbols.end())
+        return loadBias + it->second;
+    return 0;
+}
+
+
+/**
+ * Check if memory has a concrete value, loading its pages first.
+ * @param baseAddr - Start of the memory range.
+ * @param size - Length of the memory range (default=1).
+ * @return true if every byte of the range is defined.
+ */
+bool Swimmer::isConcreteMemoryValueDefined(triton::uint64 baseAddr, triton::usize size) {
+    __materializePages(baseAddr, size);
+    return triton::Context::isConcreteMemoryValueDefined(baseAddr, size);
+}
+
+
+/**
+ * Check if memory has a concrete value, loading its pages first.
+ * @param mem - Memory access to check.
+ * @return true if every byte of the access is defined.
+ */
+bool Swimmer::isConcreteMemoryValueDefined(const triton::arch::MemoryAccess& mem) {
+    __materializePages(mem.getAddress(), mem.getSize());
+    return triton::Context::isConcreteMemoryValueDefined(mem);
+}
+
+
 /**
  * Symbolizes bytes in memory with information on the source.
  * @param id - Identifying name for the memory (fgets, strcpy, etc).
  * @param ptr - Address to be symbolized.
  * @param sink - Address at which the memory was symbolized.
  * @param len - Length of the memory access.
+ * @param gran - Bytes per symbolic variable, 1 or 8 (default=1).
  * @return the SharedSymbolicVariables of the memory.
  */
-Buffer Swimmer::symbolizeNamedMemory(std::string id, triton::uint64 ptr, triton::uint64 sink, size_t len) {
+Buffer Swimmer::symbolizeNamedMemory(std::string id, triton::uint64 ptr, triton::uint64 sink, size_t len, size_t gran) {
     // Create the buffer
-    Buffer b = Buffer(id, sink, ptr, len);
+    Buffer b = Buffer(id, sink, ptr, len, gran);
 
-    // Create the symbolic variables
+    // Create the symbolic variables, whole words first and then any trailing bytes
     triton::arch::MemoryAccess mem;
     std::stringstream ss;
-    for(size_t i = 0; i < len; i++) {
-        mem = triton::arch::MemoryAccess(ptr + i, 1);
+    size_t step = b.getGranularity();
+    for(size_t i = 0; i < len; i += step) {
+        if(i + step > len)
+            step = 1;
+        mem = triton::arch::MemoryAccess(ptr + i, step);
         ss << b.alias << "[0x" << i << "]";
         b.vars.push_back(symbolizeMemory(mem, ss.str()));
+        metrics.symbolicVariables++;
         clearConcreteMemoryValue(mem);
         ss.str(std::string());
     }
+    __journal(ptr, len);
 
     // Return the resulting buffer  
     return b;
@@ -460,6 +714,8 @@ triton::engines::symbolic::SharedSymbolicVariable Swimmer::symbolizeNamedMemoryC
     triton::arch::MemoryAccess mem = triton::arch::MemoryAccess(ptr, sz);
     std::stringstream ss;
     ss << id << "<--0x" << std::hex << sink << std::dec;
+    __journal(ptr, sz);
+    metrics.symbolicVariables++;
     return symbolizeMemory(mem, ss.str());
 }
 
@@ -475,33 +731,40 @@ triton::uint64 Swimmer::allocateHeapMemory(std::string id, triton::uint64 sink,
     // Validate length
     if(len == 0) return 0;
 
-    // Start search at beginning of heap
-    triton::uint64 ptr = HEAP_START;
-
-    // Find starting address for chunk
-    while(ptr < HEAP_END) {
-        if(!isConcreteMemoryValueDefined(ptr) && !isMemorySymbolized(ptr) && !isHeapAllocated(ptr, len)) {
-            triton::uint64 i;
-            for(i = 1; i < len; i++) {
-                if(isConcreteMemoryValueDefined(ptr+i) || isMemorySymbolized(ptr+i))
-                    break;
-            }
-            if(i == len) break;
-            else ptr += i;
+    // Reuse a freed chunk of the same size class, else take fresh memory
+    size_t cap = __heapClass(len);
+    triton::uint64 ptr;
+    std::optional<Buffer> reused;
+    auto freed = heapFree.find(cap);
+    if(freed != heapFree.end() && !freed->second.empty()) {
+        ptr = freed->second.back();
+        freed->second.pop_back();
+        auto old = heapAllocations.find(ptr);
+        if(old != heapAllocations.end()) {
+            reused = old->second;
+            heapAllocations.erase(old);
         }
-        else ptr += 1;
+    }
+    else {
+        // Validate enough memory
+        if(heapTop + cap > HEAP_END) return 0;
+        ptr = heapTop;
+        heapTop += cap;
     }
 
-    // Validate enough memory
-    if(ptr + len > HEAP_END) return 0;
-
-    // Create the buffer
-    Buffer b = symbolizeNamedMemory(id, ptr, sink, len);
+    // Create the buffer, symbolized as it is read
+    Buffer b = Buffer(id, sink, ptr, len);
     heapAllocations.emplace(ptr, b);
-    if(verbosity & SV_ALLOC) {
-        std::cout << "\033[1mAllocated " << len << " bytes @ 0x"
-                  << std::hex << ptr << std::dec << "\033[0m" << std::endl;
-    }
+    heapChunks[ptr] = Live;
+    metrics.heapAllocations++;
+    regionMap.insert(ptr, ptr + len - 1, RegionMap::Heap, ptr);
+    shadow.set(ptr, len, ShadowMemory::Live);
+    shadow.set(ptr + len, cap - len, ShadowMemory::Redzone);
+    __makeLazy(ptr, len, b.alias, false);
+    regions.back().heap = true;
+    regions.back().reused = reused;
+    if(verbosity & SV_ALLOC)
+        __trace(TraceSink::Alloc, ptr, len);
 
     // Return the address for allocation
     return ptr;
@@ -510,21 +773,47 @@ triton::uint64 Swimmer::allocateHeapMemory(std::string id, triton::uint64 sink,
 
 /**
  * Free a chunk of heap memory.
+ * The chunk is quarantined before it can be reused, so that uses after
+ * free are still caught while it waits. The free is journaled, so that
+ * it is undone if its path is abandoned.
  * @param ptr - Starting address of the chunk.
  * @param sink - Address at which the buffer can be declared free'd.
  * @return true if successfully free'd, false if not allocated or already free'd.
  */
 bool Swimmer::freeHeapMemory(triton::uint64 ptr, triton::uint64 sink) {
-    for(auto &pair : heapAllocations) {
-        if(ptr == pair.first) {
-            if(verbosity & SV_ALLOC) {
-                std::cout << "\033[1mFreeing pointer @ 0x"
-                          << std::hex << ptr << std::dec << "\033[0m" << std::endl;
-            }
-            return pair.second.kill(sink);
-        }
+    auto it = heapAllocations.find(ptr);
+    if(it == heapAllocations.end())
+        return false;
+    if(verbosity & SV_ALLOC)
+        __trace(TraceSink::Free, ptr);
+    triton::uint64 prevSink = it->second.getSink();
+    if(!it->second.kill(sink))
+        return false;
+    shadow.set(ptr, it->second.getSize(), ShadowMemory::Freed);
+    heapChunks[ptr] = Quarantined;
+
+    Region r;
+    r.ptr = ptr;
+    r.len = it->second.getSize();
+    r.heap = true;
+    r.freed = true;
+    r.sink = prevSink;
+
+    // Release the oldest quarantined chunks to their free lists
+    heapQuarantine.push_back(ptr);
+    heapQuarantined += __heapClass(it->second.getSize());
+    while(heapQuarantined > heapQuarantineSize && !heapQuarantine.empty()) {
+        auto old = heapAllocations.find(heapQuarantine.front());
+        heapQuarantine.pop_front();
+        size_t cap = __heapClass(old->second.getSize());
+        heapQuarantined -= cap;
+        __unlistFree(old->first, cap);
+        heapFree[cap].push_back(old->first);
+        heapChunks[old->first] = Free;
+        r.drained.push_back(old->first);
     }
-    return false;
+    regions.push_back(r);
+    return true;
 }
 
 
@@ -535,16 +824,8 @@ bool Swimmer::freeHeapMemory(triton::uint64 ptr, triton::uint64 sink) {
  * @return true if the heap memory at ptr is alive.
  */
 bool Swimmer::statHeapMemory(triton::uint64 ptr, bool strict) {
-    for(auto &pair : heapAllocations) {
-        triton::uint64 lo = pair.first;
-        triton::uint64 hi = lo + pair.second.getSize() - 1;
-        if(ptr == lo)
-            return pair.second.stat();
-        if(!strict && ptr <= hi && ptr >= lo) {
-            return pair.second.stat();
-        }
-    }
-    return false;
+    auto it = __findHeapChunk(ptr, strict);
+    return it != heapAllocations.end() && it->second.stat();
 }
 
 
@@ -555,16 +836,8 @@ bool Swimmer::statHeapMemory(triton::uint64 ptr, bool strict) {
  * @return the origin of ptr.
  */
 triton::uint64 Swimmer::getHeapOrigin(triton::uint64 ptr, bool strict) {
-    for(auto &pair : heapAllocations) {
-        triton::uint64 lo = pair.first;
-        triton::uint64 hi = lo + pair.second.getSize() - 1;
-        if(ptr == lo)
-            return pair.second.getOrigin();
-        if(!strict && ptr <= hi && ptr >= lo) {
-            return pair.second.getOrigin();
-        }
-    }
-    return 0;
+    auto it = __findHeapChunk(ptr, strict);
+    return it != heapAllocations.end() ? it->second.getOrigin() : 0;
 }
 
 
@@ -575,16 +848,8 @@ triton::uint64 Swimmer::getHeapOrigin(triton::uint64 ptr, bool strict) {
  * @return the origin of ptr.
  */
 triton::uint64 Swimmer::getHeapSink(triton::uint64 ptr, bool strict) {
-    for(auto &pair : heapAllocations) {
-        triton::uint64 lo = pair.first;
-        triton::uint64 hi = lo + pair.second.getSize() - 1;
-        if(ptr == lo)
-            return pair.second.getSink();
-        if(!strict && ptr <= hi && ptr >= lo) {
-            return pair.second.getSink();
-        }
-    }
-    return 0;
+    auto it = __findHeapChunk(ptr, strict);
+    return it != heapAllocations.end() ? it->second.getSink() : 0;
 }
 
 
@@ -596,13 +861,12 @@ triton::uint64 Swimmer::getHeapSink(triton::uint64 ptr, bool strict) {
  * @returns true if any bytes [ptr, ptr+len-1] have been allocated.
  */
 bool Swimmer::isHeapAllocated(triton::uint64 ptr, size_t len) {
-    for(auto &pair : heapAllocations) {
-        triton::uint64 lo = pair.first;
-        triton::uint64 hi = lo + pair.second.getSize() - 1;
-        if(ptr <= hi && ptr + len - 1 >= lo)
-            return true;
-    }
-    return false;
+    // Chunks do not overlap, so only the last to start in range can reach ptr
+    auto it = heapAllocations.upper_bound(ptr + len - 1);
+    if(it == heapAllocations.begin())
+        return false;
+    it--;
+    return it->first + it->second.getSize() - 1 >= ptr;
 }
 
 
@@ -612,11 +876,7 @@ bool Swimmer::isHeapAllocated(triton::uint64 ptr, size_t len) {
  * @return true if the address points to a heap allocation.
  */
 bool Swimmer::isHeapStub(triton::uint64 ptr) {
-    for(auto &pair : heapAllocations) {
-        if(pair.first == ptr)
-            return true;
-    }
-    return false;
+    return heapAllocations.count(ptr) > 0;
 }
 
 
@@ -626,13 +886,8 @@ bool Swimmer::isHeapStub(triton::uint64 ptr) {
  * @return The owning heap address, including 0 for no owner.
  */
 triton::uint64 Swimmer::getHeapStub(triton::uint64 ptr) {
-    for(auto &pair : heapAllocations) {
-        triton::uint64 lo = pair.first;
-        triton::uint64 hi = lo + pair.second.getSize() - 1;
-        if(ptr <= hi && ptr >= lo)
-            return lo;
-    }
-    return 0;
+    auto it = __findHeapChunk(ptr, false);
+    return it != heapAllocations.end() ? it->first : 0;
 }
 
 
@@ -669,15 +924,10 @@ std::string Swimmer::getBufferAlias(triton::uint64 ptr) {
  * @return the deduced length of the buffer at ptr on the stack.
  */
 size_t Swimmer::getStackBufferLength(triton::uint64 ptr) {
-    for(Stackframe &sf : stackframes) {
-        triton::uint64 hi = sf.getAddress();
-        triton::uint64 lo = hi - sf.getSize();
-        if(ptr <= hi && ptr >= lo) {
-            ptr = hi - ptr;
-            return sf.getAccessGap(ptr);
-        }
-    }
-    return 0;
+    Stackframe *sf = getStackframe(ptr);
+    if(sf == nullptr)
+        return 0;
+    return sf->getAccessGap(sf->getAddress() - ptr);
 }
 
 
@@ -698,15 +948,10 @@ Stackframe *Swimmer::getStackframe() {
  * @return the stackframe containing ptr, or nullptr if there is no frame.
  */
 Stackframe *Swimmer::getStackframe(triton::uint64 ptr) {
-    for(Stackframe &sf : stackframes) {
-        triton::uint64 hi = sf.getAddress();
-        triton::uint64 lo = hi - sf.getSize();
-        if(ptr <= hi && ptr >= lo) {
-            ptr = hi - ptr;
-            return &sf;
-        }
-    }
-    return nullptr;
+    const RegionMap::Entry *e = regionMap.find(ptr);
+    if(e == nullptr || e->kind != RegionMap::Stack)
+        return nullptr;
+    return &stackframes[e->tag];
 }
 
 
@@ -722,6 +967,26 @@ bool Swimmer::isStackAddress(triton::uint64 ptr) {
 }
 
 
+/**
+ * Classify an address as a stackframe, heap chunk, or section.
+ * @param ptr - Address to classify.
+ * @return the region containing ptr, or nullptr if there is none.
+ */
+const RegionMap::Entry *Swimmer::getRegion(triton::uint64 ptr) {
+    return regionMap.find(ptr);
+}
+
+
+/**
+ * Get the allocation state of a byte of memory.
+ * @param ptr - Address of the byte.
+ * @return the state of the byte in the shadow memory.
+ */
+ShadowMemory::ShadowState Swimmer::getShadowState(triton::uint64 ptr) {
+    return shadow.get(ptr);
+}
+
+
 /**
  * Check if an address belongs to the heap.
  * @param ptr - Address to check
@@ -739,37 +1004,659 @@ bool Swimmer::isHeapAddress(triton::uint64 ptr) {
 
 
 /**
- * Handle changing of the stack pointer to allocate the stackframe
- * @param insn - Potential instruction to perform the change.
- * @return true if the stackframe was allocated
+ * Execute a single instruction of the current exploration
+ * @return the state of the exploration after the instruction
  */
-bool Swimmer::__handleStackAllocation(triton::arch::Instruction insn) {
-    if(insn.getType() == triton::arch::x86::ID_INS_SUB && insn.operands[0] == registers.x86_rsp) {
-        // Update the stackframe
-        triton::uint64 base = triton::uint64(getConcreteRegisterValue(registers.x86_rbp));
-        size_t sz = insn.operands[1].getImmediate().getValue();
-        if(sz > 0xFF00000000000000)
-            return false;
-        stackframes.back().update(base, sz);
+Swimmer::StepResult Swimmer::__step() {
+    // Time not spent in another phase is Koi's own bookkeeping
+    Metrics::Timer koiTimer(__timing(), Metrics::Koi);
 
-        // Create the symbolic variables
-        triton::arch::MemoryAccess mem;
-        std::stringstream ss;
-        for(size_t i = 0; i < sz; i++) {
-            mem = triton::arch::MemoryAccess(base - i, 1);
-            ss << "stackframe@0x" << std::hex
-               << insn.getAddress() << "_0x" << std::hex
-               << base << "[-0x" << i << "]";
-            symbolizeMemory(mem, ss.str());
-            clearConcreteMemoryValue(mem);
-            ss.str(std::string());
+    // Abandon a path that was followed speculatively and found infeasible
+    if(!speculations.empty() && __resolveSpeculations(false))
+        return __backtrack();
+
+    // Get the instruction pointer
+    Metrics::Timer fetchTimer(__timing(), Metrics::Fetch);
+    triton::uint64 pc = triton::uint64(getConcreteRegisterValue(registers.x86_rip));
+
+    // Ensure the instruction has not been visited too many times
+    if(exploreMaxVisits > 0) {
+        if(++visits[pc] > exploreMaxVisits) {
+            if(verbosity & SV_STOPS)
+                __trace(TraceSink::Exhausted, pc);
+            return __endPath(Exhausted, pc);
+        }
+    }
+
+    // Get the instruction bytes if they have been defined
+    if(!isConcreteMemoryValueDefined(pc, 1)) {
+        if(verbosity & SV_STOPS)
+            __trace(TraceSink::Undefined, pc);
+        return __endPath(Undefined, pc);
+    }
+    std::vector<triton::uint8> opcode = getConcreteMemoryAreaValue(pc, 16);
+
+    // Only execute segments that are executable
+    if(loadMode == Segments) {
+        const RegionMap::Entry *r = regionMap.find(pc);
+        if(r != nullptr && r->kind == RegionMap::Section && !(r->tag & PF_X)) {
+            if(verbosity & SV_STOPS)
+                __trace(TraceSink::NotExecutable, pc);
+            return __endPath(Undefined, pc);
+        }
+    }
+
+    // Initialize the next instruction
+    triton::arch::Instruction insn = injectedInstructions.count(pc)
+                                   ? injectedInstructions[pc]
+                                   : triton::arch::Instruction(pc, opcode.data(), 16);
+
+    // Process the instruction
+    fetchTimer.stop();
+    {
+        Metrics::Timer timer(__timing(), Metrics::Processing);
+        processing(insn);
+    }
+    metrics.countInstruction(pc);
+    if(recording.is_open())
+        trace.pcs.push_back(pc);
+    triton::uint32 insnType = insn.getType();
+    if(verbosity & SV_INSN)
+        __trace(TraceSink::Insn, pc, 0, insn.getDisassembly().c_str());
+    if(verbosity & SV_REGS)
+        __printRegisters();
+
+    // Report accesses to memory that is not addressable
+    if(checkAccesses && !accessHooks.empty())
+        __checkAccesses(pc, insn);
+    if(!watchpoints.empty())
+        __checkWatchpoints(pc, insn);
+
+    // Restore semantics of an injected instruction
+    if(injectedInstructions.count(pc)) {
+        Metrics::Timer timer(__timing(), Metrics::Reinject);
+        insn.symbolicExpressions = injectedInstructions[pc].symbolicExpressions;
+        disassembly(insn);
+    }
+
+    // Keep expressions within the AST limits
+    if(astMaxDepth > 0 || astMaxNodes > 0)
+        __limitExpressions(insn);
+
+    // Perform address/instruction hooks
+    if(insnHooks.count(pc)) {
+        if(__resolveSpeculations(true))
+            return __backtrack();
+        __flushTrace();
+        for(InsnHook& callback : insnHooks[pc]) {
+            Metrics::Timer timer(__timing(), Metrics::Hooks, pc);
+            metrics.hooksFired++;
+            callback(this, insn);
+        }
+    }
+
+    // Return success if target is reached
+    if(exploreTarget != 0 && pc == exploreTarget) {
+        if(verbosity & SV_STOPS)
+            __trace(TraceSink::Target, pc);
+        return __endPath(Target, pc);
+    }
+
+    // Record a model the first time each pending target is reached
+    if(pendingTargets.count(pc)) {
+        if(__resolveSpeculations(true))
+            return __backtrack();
+        if(verbosity & SV_STOPS)
+            __trace(TraceSink::TargetAt, pc);
+        pendingTargets.erase(pc);
+        targetModels[pc] = getSatModel();
+        if(pendingTargets.empty())
+            return __endPath(Target, pc);
+    }
+
+    // Return failure if dead end is reached
+    if(std::find(deadEnds.begin(), deadEnds.end(), pc) != deadEnds.end()) {
+        if(verbosity & SV_STOPS)
+            __trace(TraceSink::DeadEnd, pc);
+        return __endPath(DeadEnd, pc);
+    }
+
+    // Handle stackframe information
+    // This idoes not disqualify other handlers
+    __handleStackAllocation(insn);
+    __handleStackReference(insn);
+
+    // Settle speculation before a function hook can touch the constraints
+    if(insnType == triton::arch::x86::ID_INS_CALL && !speculations.empty()) {
+        if(funcHooks.count(triton::uint64(getConcreteRegisterValue(registers.x86_rip))) && __resolveSpeculations(true))
+            return __backtrack();
+    }
+
+    // Break on halt
+    if(insnType == triton::arch::x86::ID_INS_HLT) {
+        return __endPath(Halt, pc);
+    }
+
+    // Break on return when the next instruction is fallthrough
+    else if(insnType == triton::arch::x86::ID_INS_RET) {
+        if(getConcreteRegisterValue(registers.x86_rip) == 0) {
+            if(verbosity & SV_STOPS)
+                __trace(TraceSink::PathEnd, pc);
+            return __endPath(Return, pc);
+        } else if (stackframes.size() > 1) {
+            __popFrame();
+            if(verbosity & SV_STACK)
+                __trace(TraceSink::FrameEnd);
+        }
+    }
+
+    // Handle calls to unknown memory by skipping or hooking
+    else if(__handleCall(pathFid, pc, insn))
+        return replayDiverged ? __endPath(Diverged, pc) : Paused;
+
+    // Check for new symbolic stack variables
+    else if(__handleMemoryRead(pc, insn))
+        return Paused;
+
+    // Fork at symbolic conditional branch
+    else if(insn.isBranch() && insn.isSymbolized() && insnType != triton::arch::x86::ID_INS_JMP) {
+        // Forking is only possible if an instruction is symbolized
+        std::vector<triton::ast::SharedAbstractNode> ite = getIte(insn);
+
+        // A replayed or resumed path follows its recorded branches instead
+        if(ite.size() == 3 && (replaying || resuming))
+            return __replayBranch(pc, ite);
+
+        // Offload the solver and continue down the concretely taken side
+        if(ite.size() == 3 && solverPool)
+            return __speculate(pc, ite);
+
+        // The symbolic statement was found
+        if(ite.size() == 3) {
+            triton::ast::SharedAstContext astCtxt = getAstContext();
+
+            // Determine satisfiable model for "if"
+            triton::engines::solver::status_e status_if, status_else;
+            cnstrs.push_back(ite[0]);
+            triton::ast::SharedAbstractNode cnstr_if = cnstrs.size() > 1 ? astCtxt->land(cnstrs) : cnstrs[0];
+            std::unordered_map<long unsigned int, triton::engines::solver::SolverModel> model_if = getModel(cnstr_if, &status_if);
+            cnstrs.pop_back();
+
+            // Determine satisfiable model for "else"
+            cnstrs.push_back(astCtxt->lnot(ite[0]));
+            triton::ast::SharedAbstractNode cnstr_else = cnstrs.size() > 1 ? astCtxt->land(cnstrs) : cnstrs[0];
+            std::unordered_map<long unsigned int, triton::engines::solver::SolverModel> model_else = getModel(cnstr_else, &status_else);
+            cnstrs.pop_back();
+
+            // Sides the solver could not decide are handled by the unknown policy
+            bool sat_if = model_if.size() > 0;
+            bool sat_else = model_else.size() > 0;
+            bool unknown_if = !sat_if && status_if != triton::engines::solver::UNSAT;
+            bool unknown_else = !sat_else && status_else != triton::engines::solver::UNSAT;
+            bool defer = false;
+            if(unknownPolicy == Optimistic) {
+                solverStats.followed += unknown_if + unknown_else;
+                sat_if |= unknown_if;
+                sat_else |= unknown_else;
+            }
+            else if(unknownPolicy == Defer && ((sat_if && unknown_else) || (sat_else && unknown_if)))
+                defer = true;
+            else {
+                solverStats.skipped += unknown_if + unknown_else;
+                metrics.prunedPaths += unknown_if + unknown_else;
+            }
+
+            // Only fork if both satisfiable, else defer to Triton
+            if((sat_if && sat_else) || defer) {
+                // Verify exection depth is not too complex
+                if(exploreMaxDepth > 0 && depth >= exploreMaxDepth) {
+                    if(verbosity & SV_STOPS)
+                        __trace(TraceSink::TooDeep, pc);
+                    metrics.prunedPaths++;
+                    return __followConcrete(pc, ite);
+                }
+
+                // Follow the jump unless it is the undecided side
+                bool jump = !defer || sat_if;
+
+                // Save the other side to resume once this one is explored
+                // TODO: Save and restore all registers, not just RBP
+                // TODO: This will need to be done for memory as well
+                Fork f;
+                f.pc = pc;
+                f.jump = !jump;
+                f.dst = triton::uint64(ite[jump ? 2 : 1]->evaluate());
+                f.rbp = triton::uint64(getConcreteRegisterValue(registers.x86_rbp));
+                f.nBranches = branches.size();
+                f.nCnstrs = cnstrs.size();
+                f.nDecisions = decisions.size();
+                f.nFrames = frameJournal.size();
+                f.nRegions = regions.size();
+                f.nPcs = trace.pcs.size();
+                f.nHooks = trace.hooks.size();
+                f.cnstr = jump ? cnstr_else : cnstr_if;
+                f.model = jump ? model_else : model_if;
+                f.fid = pathFid;
+                f.depth = depth;
+                if(defer)
+                    __defer(f);
+                else
+                    forks.push_back(f);
+
+                // Follow the chosen side as a new path
+                setConcreteRegisterValue(registers.x86_rip, ite[jump ? 1 : 2]->evaluate());
+                cnstrs.push_back(jump ? cnstr_if : cnstr_else);
+                branches.push_back({pc, jump});
+                decisions.push_back({pc, jump});
+                pathFid = fid++;
+                depth++;
+                if(verbosity & SV_BRANCH)
+                    __trace(TraceSink::Branch, pc, jump);
+                if(verbosity & SV_MODEL) {
+                    __flushTrace();
+                    for (const auto& pair : (jump ? model_if : model_else)) {
+                        std::cout << "\t" << pair.first << ": "<< pair.second << std::endl;
+                    }
+                }
+                metrics.forks++;
+                return Forked;
+
+            } // sat && sat
+
+            // Triton's concrete side may be one the solver could not decide, which is not followed either
+            bool taken = triton::uint64(getConcreteRegisterValue(registers.x86_rip)) == triton::uint64(ite[1]->evaluate());
+            if(unknownPolicy != Optimistic && (taken ? unknown_if : unknown_else)) {
+                if(!(taken ? sat_else : sat_if))
+                    return __backtrack();
+                setConcreteRegisterValue(registers.x86_rip, ite[taken ? 2 : 1]->evaluate());
+                cnstrs.push_back(taken ? cnstr_else : cnstr_if);
+                branches.push_back({pc, !taken});
+                if(verbosity & SV_BRANCH)
+                    __trace(TraceSink::Branch, pc, !taken);
+                return Paused;
+            }
+            return __followConcrete(pc, ite);
+
+        } // found ite
+
+    } // is symbolic branch
+
+    return Paused;
+}
+
+
+/**
+ * Resume the most recent fork after a path terminates
+ * @return Paused if a fork was resumed, else Finished
+ */
+Swimmer::StepResult Swimmer::__backtrack() {
+    resuming = false;
+
+    // Deferred forks are retried with more time once nothing else is left
+    while(forks.empty() && !deferred.empty()) {
+        Deferral d = deferred.front();
+        deferred.pop_front();
+        d.fork.model = __solve(d.fork.cnstr, nullptr, deferredTimeout);
+        if(!d.fork.model.empty())
+            return __resume(d);
+    }
+
+    // Nothing left to explore
+    if(forks.empty()) {
+        depth = 0;
+        exploring = false;
+        return Finished;
+    }
+    Fork f = forks.back();
+    forks.pop_back();
+
+    // Release what the abandoned path created, compacting now and then
+    __release(f.nRegions);
+    clearPathConstraints();
+    if(compactInterval > 0 && ++backtracks % compactInterval == 0)
+        compact();
+
+    // Restore the state of the path at the fork
+    branches.resize(f.nBranches);
+    cnstrs.resize(f.nCnstrs);
+    decisions.resize(f.nDecisions);
+    trace.pcs.resize(f.nPcs);
+    trace.hooks.resize(f.nHooks);
+    __rewindFrames(f.nFrames);
+    setConcreteRegisterValue(registers.x86_rbp, f.rbp);
+    pathFid = f.fid;
+    depth = f.depth;
+
+    // Restore to the other side of the branch
+    if(verbosity & SV_BRANCH)
+        __trace(TraceSink::Branch, f.pc, f.jump);
+    if(verbosity & SV_MODEL) {
+        __flushTrace();
+        for (const auto& pair : f.model) {
+            std::cout << "\t" << pair.first << ": "<< pair.second << std::endl;
         }
+    }
+    setConcreteRegisterValue(registers.x86_rip, f.dst);
+    cnstrs.push_back(f.cnstr);
+    branches.push_back({f.pc, f.jump});
+    decisions.push_back({f.pc, f.jump});
+    return Paused;
+}
 
-        if(verbosity & SV_STACK) {
-            std::cout << "\033[1mIdentified stackframe @ 0x"
-                      << std::hex << base << " has 0x"
-                      << sz << " bytes\033[0m" << std::dec << std::endl;
+
+/**
+ * Resume a deferred fork by following its path again from the entry
+ * The journal, call stack and registers belong to whichever path ran last,
+ * not to the deferral's, so they are rewound to the entry of the exploration.
+ * The deferral's branches are then followed as a replay would, until its
+ * undecided side is taken and the path is explored as usual.
+ * @param d - Deferral to resume.
+ * @return Paused, once the path is set to follow
+ */
+Swimmer::StepResult Swimmer::__resume(const Deferral& d) {
+    // Rewind to the entry, releasing what every path created
+    __release(entry.nRegions);
+    clearPathConstraints();
+    branches.resize(entry.nBranches);
+    cnstrs.resize(entry.nCnstrs);
+    decisions.resize(entry.nDecisions);
+    trace.pcs.clear();
+    trace.hooks.clear();
+    __rewindFrames(entry.nFrames);
+    setConcreteRegisterValue(registers.x86_rbp, entry.rbp);
+    setConcreteRegisterValue(registers.x86_rsp, entry.rsp);
+    setConcreteRegisterValue(registers.x86_rip, entry.pc);
+    pathFid = d.fork.fid;
+    depth = d.fork.depth;
+
+    // Follow the deferral's branches, ending with the undecided side
+    replayPath = PathTrace();
+    replayPath.branches = d.branches;
+    replayPath.branches.push_back({d.fork.pc, d.fork.jump});
+    replayPath.decisions = d.decisions;
+    replayPath.decisions.push_back({d.fork.pc, d.fork.jump});
+    replayNext = 0;
+    resuming = true;
+    if(verbosity & SV_MODEL) {
+        __flushTrace();
+        for (const auto& pair : d.fork.model) {
+            std::cout << "\t" << pair.first << ": "<< pair.second << std::endl;
         }
+    }
+    return Paused;
+}
+
+
+/**
+ * Fork at a symbolic branch without waiting for the solver
+ * Both directions are queried by the solver pool while the concretely taken
+ * side is followed. The other side becomes a fork once its answer arrives.
+ * @param pc - Address of the branch.
+ * @param ite - Children of the branch if-then-else.
+ * @return the state of the exploration after the branch
+ */
+Swimmer::StepResult Swimmer::__speculate(triton::uint64 pc, const std::vector<triton::ast::SharedAbstractNode>& ite) {
+    // Verify exection depth is not too complex
+    if(exploreMaxDepth > 0 && depth >= exploreMaxDepth) {
+        if(verbosity & SV_STOPS)
+            __trace(TraceSink::TooDeep, pc);
+        metrics.prunedPaths++;
+        return __followConcrete(pc, ite);
+    }
+
+    // Determine which side Triton concretely followed
+    triton::ast::SharedAstContext astCtxt = getAstContext();
+    bool jump = triton::uint64(getConcreteRegisterValue(registers.x86_rip)) == triton::uint64(ite[1]->evaluate());
+
+    // Constraints for the taken and flipped sides
+    cnstrs.push_back(jump ? ite[0] : astCtxt->lnot(ite[0]));
+    triton::ast::SharedAbstractNode cnstr_taken = cnstrs.size() > 1 ? astCtxt->land(cnstrs) : cnstrs[0];
+    cnstrs.pop_back();
+    cnstrs.push_back(jump ? astCtxt->lnot(ite[0]) : ite[0]);
+    triton::ast::SharedAbstractNode cnstr_flipped = cnstrs.size() > 1 ? astCtxt->land(cnstrs) : cnstrs[0];
+    cnstrs.pop_back();
+
+    // The flipped side is a fork that waits on the solver
+    Speculation spec;
+    spec.fork.pc = pc;
+    spec.fork.jump = !jump;
+    spec.fork.dst = triton::uint64(ite[jump ? 2 : 1]->evaluate());
+    spec.fork.rbp = triton::uint64(getConcreteRegisterValue(registers.x86_rbp));
+    spec.fork.nBranches = branches.size();
+    spec.fork.nCnstrs = cnstrs.size();
+    spec.fork.nDecisions = decisions.size();
+    spec.fork.nFrames = frameJournal.size();
+    spec.fork.nRegions = regions.size();
+    spec.fork.nPcs = trace.pcs.size();
+    spec.fork.nHooks = trace.hooks.size();
+    spec.fork.cnstr = cnstr_flipped;
+    spec.fork.fid = pathFid;
+    spec.fork.depth = depth;
+    spec.nForks = forks.size();
+    spec.taken = solverPool->submit(cnstr_taken);
+    spec.flipped = solverPool->submit(cnstr_flipped);
+    speculations.push_back(std::move(spec));
+
+    // Follow the taken side as a new path
+    cnstrs.push_back(cnstr_taken);
+    branches.push_back({pc, jump});
+    decisions.push_back({pc, jump});
+    pathFid = fid++;
+    depth++;
+    metrics.forks++;
+    if(verbosity & SV_BRANCH)
+        __trace(TraceSink::Branch, pc, jump);
+    return Forked;
+}
+
+
+/**
+ * Follow the side of a symbolic branch that Triton concretely took
+ * The branch is not forked, but its side is recorded so a replay takes it too.
+ * @param pc - Address of the branch.
+ * @param ite - Children of the branch if-then-else.
+ * @return the state of the exploration after the branch
+ */
+Swimmer::StepResult Swimmer::__followConcrete(triton::uint64 pc, const std::vector<triton::ast::SharedAbstractNode>& ite) {
+    bool jump = triton::uint64(getConcreteRegisterValue(registers.x86_rip)) == triton::uint64(ite[1]->evaluate());
+    branches.push_back({pc, jump});
+    return Paused;
+}
+
+
+/**
+ * Follow the recorded side of a symbolic branch without the solver
+ * Every symbolic branch of a recorded path is kept, forked or not, so a
+ * branch other than the next recorded one means the path diverged, as does
+ * a symbolic branch after the last recorded one. A resumed deferral goes
+ * back to exploring once its last branch, the undecided side, is taken.
+ * @param pc - Address of the branch.
+ * @param ite - Children of the branch if-then-else.
+ * @return the state of the exploration after the branch
+ */
+Swimmer::StepResult Swimmer::__replayBranch(triton::uint64 pc, const std::vector<triton::ast::SharedAbstractNode>& ite) {
+    if(replayNext >= replayPath.branches.size() || replayPath.branches[replayNext].first != pc) {
+        replayDiverged = replaying;
+        return __endPath(Diverged, pc);
+    }
+    bool jump = replayPath.branches[replayNext++].second;
+
+    // Follow the recorded side, keeping its constraint for later models
+    triton::ast::SharedAstContext astCtxt = getAstContext();
+    setConcreteRegisterValue(registers.x86_rip, ite[jump ? 1 : 2]->evaluate());
+    cnstrs.push_back(jump ? ite[0] : astCtxt->lnot(ite[0]));
+    branches.push_back({pc, jump});
+    if(verbosity & SV_BRANCH)
+        __trace(TraceSink::Branch, pc, jump);
+
+    // The deferral is reached, so its decisions are the path's
+    if(resuming && replayNext == replayPath.branches.size()) {
+        decisions.insert(decisions.end(), replayPath.decisions.begin(), replayPath.decisions.end());
+        resuming = false;
+    }
+    return Paused;
+}
+
+
+/**
+ * Collect the answers to speculative forks, oldest first
+ * @param block - Wait for every answer instead of stopping at the first pending one.
+ * @return true if the current path was found infeasible
+ */
+bool Swimmer::__resolveSpeculations(bool block) {
+    while(!speculations.empty()) {
+        Speculation& spec = speculations.front();
+
+        // Polling stops at the first unanswered speculation to keep forks ordered
+        if(!block) {
+            bool ready = spec.taken.wait_for(std::chrono::seconds(0)) == std::future_status::ready
+                      && spec.flipped.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+            if(!ready)
+                return false;
+        }
+        SolverPool::Answer taken = spec.taken.get();
+        SolverPool::Answer flipped = spec.flipped.get();
+        spec.fork.model = flipped.model;
+        metrics.addSolverTime(taken.nanos + flipped.nanos, spec.fork.pc);
+
+        // The followed side is only abandoned if it is known infeasible, or skipped
+        bool infeasible = false;
+        bool unknown_taken = __countOutcome(taken.status);
+        bool unknown_flipped = __countOutcome(flipped.status);
+        if(taken.model.empty() && unknown_taken) {
+            infeasible = unknownPolicy == Skip;
+            if(infeasible)
+                solverStats.skipped++;
+            else
+                solverStats.followed++;
+        }
+        else
+            infeasible = taken.model.empty();
+
+        // An undecided flipped side is skipped, forked anyway, or deferred
+        bool forkable = !flipped.model.empty();
+        if(!forkable && unknown_flipped) {
+            if(unknownPolicy == Optimistic) {
+                solverStats.followed++;
+                forkable = true;
+            }
+            else if(unknownPolicy == Defer)
+                __defer(spec.fork);
+            else {
+                solverStats.skipped++;
+                metrics.prunedPaths++;
+            }
+        }
+
+        // Forks made after an infeasible speculation are infeasible too
+        if(infeasible)
+            forks.resize(spec.nForks);
+
+        // Enqueue the flipped state where it would have been forked, or discard it
+        if(forkable) {
+            forks.insert(forks.begin() + spec.nForks, spec.fork);
+            for(Speculation& later : speculations)
+                later.nForks++;
+        }
+        triton::uint64 pc = spec.fork.pc;
+        speculations.pop_front();
+
+        // The rest of the path was followed in vain
+        if(infeasible) {
+            speculations.clear();
+            metrics.prunedPaths++;
+            if(verbosity & SV_STOPS)
+                __trace(TraceSink::SpeculationFailed, pc);
+            return true;
+        }
+    }
+    return false;
+}
+
+
+/**
+ * Deliver a terminated path to every path hook
+ * @param reason - Why the path terminated.
+ * @param pc - Address of the final instruction.
+ * @return the state of the exploration after the path
+ */
+Swimmer::StepResult Swimmer::__endPath(PathEnd reason, triton::uint64 pc) {
+    // A path that was only followed speculatively is not delivered
+    if(__resolveSpeculations(true))
+        return __backtrack();
+
+    __flushTrace();
+    for(PathHook& callback : pathHooks) {
+        metrics.hooksFired++;
+        callback(this, reason, pc);
+    }
+
+    // Append the path to the trace file, or check a replayed path symbolized what was recorded
+    if(recording.is_open() || replaying) {
+        trace.reason = reason;
+        trace.endPc = pc;
+        trace.branches = branches;
+        trace.decisions = decisions;
+        trace.regions.clear();
+        for(const Region& r : regions) {
+            if(!r.freed)
+                trace.regions.push_back({r.ptr, r.len, r.heap});
+        }
+    }
+    if(recording.is_open()) {
+        trace.write(recording);
+        recording.flush();
+    }
+    if(replaying) {
+        auto same = [](const PathTrace::SymbolicRegion& a, const PathTrace::SymbolicRegion& b) {
+            return a.ptr == b.ptr && a.len == b.len && a.heap == b.heap;
+        };
+        const std::vector<PathTrace::SymbolicRegion>& recorded = replayPath.regions;
+        if(!std::equal(trace.regions.begin(), trace.regions.end(), recorded.begin(), recorded.end(), same))
+            replayDiverged = true;
+    }
+
+    // Reaching the target ends the exploration
+    if(reason == Target) {
+        exploring = false;
+        return Succeeded;
+    }
+    return __backtrack();
+}
+
+
+/**
+ * Handle changing of the stack pointer to allocate the stackframe
+ * @param insn - Potential instruction to perform the change.
+ * @return true if the stackframe was allocated
+ */
+bool Swimmer::__handleStackAllocation(triton::arch::Instruction insn) {
+    Metrics::Timer timer(__timing(), Metrics::StackAllocation);
+    if(insn.getType() == triton::arch::x86::ID_INS_SUB && insn.operands[0] == registers.x86_rsp) {
+        // Update the stackframe
+        triton::uint64 base = triton::uint64(getConcreteRegisterValue(registers.x86_rbp));
+        size_t sz = insn.operands[1].getImmediate().getValue();
+        if(sz > 0xFF00000000000000)
+            return false;
+        FrameChange c;
+        c.kind = FrameUpdate;
+        c.frame = stackframes.back();
+        frameJournal.push_back(c);
+        __unmapFrame(stackframes.size() - 1);
+        stackframes.back().update(base, sz);
+        __mapFrame(stackframes.size() - 1);
+
+        // Symbolize the frame as it is read
+        if(sz > 0) {
+            std::stringstream ss;
+            ss << "stackframe@0x" << std::hex
+               << insn.getAddress() << "_0x" << std::hex
+               << base << std::dec;
+            __makeLazy(base - sz + 1, sz, ss.str(), true);
+        }
+
+        if(verbosity & SV_STACK)
+            __trace(TraceSink::Frame, base, sz);
 
         return true;
     }
@@ -783,6 +1670,7 @@ bool Swimmer::__handleStackAllocation(triton::arch::Instruction insn) {
  * @return true if the stackframe was accessed
  */
 bool Swimmer::__handleStackReference(triton::arch::Instruction insn) {
+    Metrics::Timer timer(__timing(), Metrics::StackReference);
     // A stack reference has two operands
     if(insn.operands.size() == 2) {
         bool refFound = false;
@@ -797,11 +1685,15 @@ bool Swimmer::__handleStackReference(triton::arch::Instruction insn) {
                     triton::uint64 disp = -memSrc.getDisplacement().getValue();
                     bool newAccess = stackframes.back().addAccess(disp);
                     refFound = true;
-
-                    if(newAccess && verbosity & SV_STACK) {
-                        std::cout << "\033[1mNew access to stackframe @ 0x" << std::hex
-                                  << disp << "\033[0m" << std::endl;
+                    if(newAccess) {
+                        FrameChange c;
+                        c.kind = FrameAccess;
+                        c.offs = disp;
+                        frameJournal.push_back(c);
                     }
+
+                    if(newAccess && verbosity & SV_STACK)
+                        __trace(TraceSink::FrameAccess, disp);
                 }
             }
         }
@@ -828,22 +1720,34 @@ bool Swimmer::__handleCall(uint localFid, triton::uint64 pc, triton::arch::Instr
             // Perform function hooks
             if(isHooked) {
                 if(verbosity & SV_INSN)
-                    std::cout << "[" << localFid << "] " << "(" << depth << ") "
-                              << "0x------  [func hook]" << std::endl;
+                    __trace(TraceSink::FuncHook, dst);
+                __flushTrace();
                 for(FuncHook& callback : funcHooks[dst]) {
+                    Metrics::Timer timer(__timing(), Metrics::Hooks, dst);
+                    metrics.hooksFired++;
                     triton::uint64 retVal = callback(this, pc);
                     setConcreteRegisterValue(registers.x86_rax, retVal);
+                    if(recording.is_open())
+                        trace.hooks.push_back({pc, dst, retVal});
+
+                    // A replayed hook must be the recorded call, returning the same value
+                    if(replaying) {
+                        const std::vector<PathTrace::HookCall>& recorded = replayPath.hooks;
+                        if(replayHook >= recorded.size() || recorded[replayHook].pc != pc
+                            || recorded[replayHook].dst != dst || recorded[replayHook].ret != retVal)
+                            replayDiverged = true;
+                        replayHook++;
+                    }
                 }
             }
             // Just step over
             else if (verbosity & SV_INSN)
-                std::cout << "[" << localFid << "] " << "(" << depth << ") "
-                            << "0x------  [step over]" << std::endl;
+                __trace(TraceSink::StepOver, dst);
             triton::uint512 correctedRsp = getConcreteRegisterValue(registers.x86_rsp) + 8;
             setConcreteRegisterValue(registers.x86_rsp, correctedRsp);
             setConcreteRegisterValue(registers.x86_rip, insn.getNextAddress());
         } else {
-            stackframes.push_back(Stackframe());
+            __pushFrame();
         }
         return isHooked || isUndefined;
     }
@@ -858,6 +1762,7 @@ bool Swimmer::__handleCall(uint localFid, triton::uint64 pc, triton::arch::Instr
  * @return if the memory was symbolized.
  */
 bool Swimmer::__handleMemoryRead(triton::uint64 pc, triton::arch::Instruction insn) {
+    Metrics::Timer timer(__timing(), Metrics::MemoryRead);
     // Instruction is a candidate memory read
     if(insn.isMemoryRead() && insn.operands.size() == 2 && insn.operands[1].getType() == triton::arch::OP_MEM) {
         // Check if the memory access is one we care about
@@ -871,6 +1776,8 @@ bool Swimmer::__handleMemoryRead(triton::uint64 pc, triton::arch::Instruction in
             std::stringstream ss;
             ss << "stackMem<--0x" << std::hex << pc << std::dec;
             symbolizeMemory(memSrc, ss.str());
+            metrics.symbolicVariables++;
+            __journal(memSrc.getAddress(), memSrc.getSize());
             processing(insn);
             return true;
         }
@@ -893,6 +1800,8 @@ bool Swimmer::__handleMemoryRead(triton::uint64 pc, triton::arch::Instruction in
             std::stringstream ss;
             ss << "stackMem<--0x" << std::hex << pc << std::dec;
             symbolizeMemory(memSrc, ss.str());
+            metrics.symbolicVariables++;
+            __journal(memSrc.getAddress(), memSrc.getSize());
             processing(insn);
         }
         return fromRbp && !defined && !symbolized;
@@ -901,11 +1810,686 @@ bool Swimmer::__handleMemoryRead(triton::uint64 pc, triton::arch::Instruction in
 }
 
 
+/**
+ * Concretize expressions written by an instruction that exceed the AST limits
+ * Each is fixed to its value under a model of the current constraints, and
+ * the equality is recorded as a constraint so the path stays consistent.
+ * The program counter is left alone so that branches can still fork.
+ * @param insn - Processed instruction.
+ */
+void Swimmer::__limitExpressions(triton::arch::Instruction& insn) {
+    // Find the expressions that are too deep or too large
+    std::vector<triton::engines::symbolic::SharedSymbolicExpression> oversized;
+    for(const auto& expr : insn.symbolicExpressions) {
+        const triton::ast::SharedAbstractNode& ast = expr->getAst();
+        if((!expr->isMemory() && !expr->isRegister()) || !ast->isSymbolized())
+            continue;
+        if(expr->isRegister() && expr->getOriginRegister() == registers.x86_rip)
+            continue;
+        if((astMaxDepth > 0 && ast->getLevel() > astMaxDepth)
+        || (astMaxNodes > 0 && SolverPool::countNodes(ast, astMaxNodes + 1) > astMaxNodes))
+            oversized.push_back(expr);
+    }
+    if(oversized.empty())
+        return;
+
+    // Evaluate under a model of the path without disturbing the concrete state
+    triton::ast::SharedAstContext astCtxt = getAstContext();
+    std::vector<std::pair<std::string, triton::uint512>> saved;
+    for(const auto& pair : getSatModel()) {
+        const std::string& name = pair.second.getVariable()->getName();
+        saved.push_back({name, astCtxt->getVariableValue(name)});
+        astCtxt->updateVariable(name, pair.second.getValue());
+    }
+    std::vector<triton::uint512> values;
+    for(const auto& expr : oversized)
+        values.push_back(expr->getAst()->evaluate());
+    for(const auto& pair : saved)
+        astCtxt->updateVariable(pair.first, pair.second);
+
+    // Pin each expression to its value
+    for(size_t i = 0; i < oversized.size(); i++) {
+        const triton::ast::SharedAbstractNode& ast = oversized[i]->getAst();
+        cnstrs.push_back(astCtxt->equal(ast, astCtxt->bv(values[i], ast->getBitvectorSize())));
+        if(oversized[i]->isMemory()) {
+            const triton::arch::MemoryAccess& mem = oversized[i]->getOriginMemory();
+            concretizeMemory(mem);
+            setConcreteMemoryValue(mem, values[i]);
+        }
+        else {
+            const triton::arch::Register& reg = oversized[i]->getOriginRegister();
+            concretizeRegister(reg);
+            setConcreteRegisterValue(reg, values[i]);
+        }
+        astConcretizations++;
+        if(verbosity & SV_SYMS)
+            __trace(TraceSink::Concretized, insn.getAddress());
+    }
+}
+
+
+/**
+ * Mark memory to be symbolized a byte at a time as it is first read
+ * Stale values left by earlier use of the memory are dropped, and any lazy
+ * region it overlaps is set aside. The memory is journaled along with the
+ * regions it set aside, which are lazy again once its path is abandoned.
+ * @param ptr - Starting address of the memory.
+ * @param len - Length of the memory.
+ * @param name - Name that each symbolic byte is derived from.
+ * @param stack - If the memory is a stackframe, named downwards from its base.
+ */
+void Swimmer::__makeLazy(triton::uint64 ptr, size_t len, const std::string& name, bool stack) {
+    __journal(ptr, len);
+    auto it = lazyRegions.lower_bound(ptr);
+    if(it != lazyRegions.begin() && std::prev(it)->first + std::prev(it)->second.len > ptr)
+        it--;
+    while(it != lazyRegions.end() && it->first < ptr + len) {
+        regions.back().displaced.push_back(*it);
+        it = lazyRegions.erase(it);
+    }
+
+    for(size_t i = 0; i < len; i++) {
+        concretizeMemory(ptr + i);
+        clearConcreteMemoryValue(triton::arch::MemoryAccess(ptr + i, 1));
+    }
+
+    LazyRegion lazy;
+    lazy.len = len;
+    lazy.name = name;
+    lazy.stack = stack;
+    lazyRegions.emplace(ptr, lazy);
+}
+
+
+/**
+ * Check if an address is in memory marked to be symbolized lazily
+ * @param ptr - Address to check.
+ * @return true if the address is in a lazy region.
+ */
+bool Swimmer::__isLazy(triton::uint64 ptr) {
+    auto it = lazyRegions.upper_bound(ptr);
+    if(it == lazyRegions.begin())
+        return false;
+    it--;
+    return ptr < it->first + it->second.len;
+}
+
+
+/**
+ * Set up the registers and call stack as they are right after loading
+ * General purpose, flag and XMM registers are symbolized, so that values
+ * the program reads before writing are inputs.
+ */
+void Swimmer::__initState() {
+    // Registers with assumed starting values
+    // TODO: This should be handled by the loader
+    setConcreteRegisterValue(registers.x86_rip, 0);
+    setConcreteRegisterValue(registers.x86_rbp, STACK_START);
+    setConcreteRegisterValue(registers.x86_rsp, STACK_START);
+
+    // General-use registers
+    symbolizeRegister(registers.x86_rax, "symbolic_rax");
+    symbolizeRegister(registers.x86_rbx, "symbolic_rbx");
+    symbolizeRegister(registers.x86_rcx, "symbolic_rcx");
+    symbolizeRegister(registers.x86_rdx, "symbolic_rdx");
+    symbolizeRegister(registers.x86_rsi, "symbolic_rsi");
+    symbolizeRegister(registers.x86_rdi, "symbolic_rdi");
+    symbolizeRegister(registers.x86_r8, "symbolic_r8");
+    symbolizeRegister(registers.x86_r9, "symbolic_r9");
+    symbolizeRegister(registers.x86_r10, "symbolic_r10");
+    symbolizeRegister(registers.x86_r11, "symbolic_r11");
+    symbolizeRegister(registers.x86_r12, "symbolic_r12");
+    symbolizeRegister(registers.x86_r13, "symbolic_r13");
+    symbolizeRegister(registers.x86_r14, "symbolic_r14");
+    symbolizeRegister(registers.x86_r15, "symbolic_r15");
+
+    // Common flag registers
+    symbolizeRegister(registers.x86_cf, "symbolic_cf");
+    symbolizeRegister(registers.x86_of, "symbolic_of");
+    symbolizeRegister(registers.x86_pf, "symbolic_pf");
+    symbolizeRegister(registers.x86_sf, "symbolic_sf");
+    symbolizeRegister(registers.x86_tf, "symbolic_tf");
+    symbolizeRegister(registers.x86_zf, "symbolic_zf");
+
+    // XMM registers
+    symbolizeRegister(registers.x86_xmm0, "symbolic_xmm0");
+    symbolizeRegister(registers.x86_xmm1, "symbolic_xmm1");
+    symbolizeRegister(registers.x86_xmm2, "symbolic_xmm2");
+    symbolizeRegister(registers.x86_xmm3, "symbolic_xmm3");
+    symbolizeRegister(registers.x86_xmm4, "symbolic_xmm4");
+    symbolizeRegister(registers.x86_xmm5, "symbolic_xmm5");
+    symbolizeRegister(registers.x86_xmm6, "symbolic_xmm6");
+    symbolizeRegister(registers.x86_xmm7, "symbolic_xmm7");
+    symbolizeRegister(registers.x86_xmm8, "symbolic_xmm8");
+    symbolizeRegister(registers.x86_xmm9, "symbolic_xmm9");
+    symbolizeRegister(registers.x86_xmm10, "symbolic_xmm10");
+    symbolizeRegister(registers.x86_xmm11, "symbolic_xmm11");
+    symbolizeRegister(registers.x86_xmm12, "symbolic_xmm12");
+    symbolizeRegister(registers.x86_xmm13, "symbolic_xmm13");
+    symbolizeRegister(registers.x86_xmm14, "symbolic_xmm14");
+    symbolizeRegister(registers.x86_xmm15, "symbolic_xmm15");
+
+    // Initialize the stackframe as not existing
+    stackframes.push_back(Stackframe(STACK_START, 0));
+    __mapFrame(0);
+}
+
+
+/**
+ * Prepare the image to be loaded a page at a time
+ * Allocated sections with bits are placed at their addresses plus the
+ * base, except .plt.sec, while sections such as .symtab have no address
+ * to be placed at. PT_LOAD segments are placed at their virtual addresses, offset
+ * by the base when the image is position independent, and the PLT is left
+ * undefined. Either way, calls to unresolved imports are handled as calls
+ * to unknown memory. Pages are copied from the shared image on first
+ * access, by a memory callback or an explicit check. The same callback
+ * symbolizes lazy memory as it is read, including by implicit operands
+ * such as those of pop, ret, and string instructions.
+ * @param base - Address to load the image at.
+ */
+void Swimmer::__loadImage(triton::uint64 base) {
+    loadBias = (loadMode == Sections || image->pie) ? base : 0;
+    if(loadMode == Sections) {
+        for(auto& section : image->sections) {
+            if(!(section.flags & SHF_ALLOC) || section.name == ".plt.sec" || section.size == 0)
+                continue;
+            triton::uint64 lo = loadBias + section.offset;
+            __addSpan(lo, section.data, section.size, section.size);
+            regionMap.insert(lo, lo + section.size - 1, RegionMap::Section, 0, section.name);
+        }
+    }
+    else {
+        for(size_t i = 0; i < image->segments.size(); i++) {
+            auto& segment = image->segments[i];
+            if(segment.memsz == 0)
+                continue;
+            triton::uint64 lo = loadBias + segment.vaddr;
+            __addSpan(lo, segment.data, segment.filesz, segment.memsz);
+
+            std::stringstream ss;
+            ss << "LOAD[" << i << "]";
+            regionMap.insert(lo, lo + segment.memsz - 1, RegionMap::Section, segment.flags, ss.str());
+        }
+        for(auto& section : image->sections) {
+            bool plt = section.name == ".plt" || section.name == ".plt.sec" || section.name == ".plt.got";
+            if(plt && section.size > 0)
+                loadHoles.push_back({loadBias + section.offset, loadBias + section.offset + section.size});
+        }
+    }
+
+    // Reads of memory load their pages first
+    __armPages();
+    addCallback(triton::callbacks::GET_CONCRETE_MEMORY_VALUE, triton::callbacks::getConcreteMemoryValueCallback(
+        [this](triton::Context&, const triton::arch::MemoryAccess& mem) {
+            __materializePages(mem.getAddress(), mem.getSize());
+            materializeMemory(mem.getAddress(), mem.getSize());
+        }, this));
+}
+
+
+/**
+ * Add a span of the image to be loaded a page at a time
+ * @param addr - Address to load the span at.
+ * @param data - Bytes of the span in the image.
+ * @param filesz - Number of bytes in the image.
+ * @param memsz - Number of bytes in memory, zero-filled past filesz.
+ */
+void Swimmer::__addSpan(triton::uint64 addr, const unsigned char *data, size_t filesz, size_t memsz) {
+    LoadSpan span;
+    span.addr = addr;
+    span.data = data;
+    span.filesz = filesz;
+    span.memsz = memsz;
+    loadSpans.push_back(span);
+}
+
+
+/**
+ * Mark every page of the image as not yet copied into memory
+ */
+void Swimmer::__armPages() {
+    for(auto& span : loadSpans) {
+        for(triton::uint64 page = span.addr & ~triton::uint64(PAGE_SIZE - 1); page < span.addr + span.memsz; page += PAGE_SIZE)
+            lazyPages.insert(page);
+    }
+}
+
+
+/**
+ * Load the pages of a memory range that have not been loaded yet
+ * @param ptr - Start of the memory range.
+ * @param len - Length of the memory range.
+ */
+void Swimmer::__materializePages(triton::uint64 ptr, size_t len) {
+    if(lazyPages.empty() || len == 0)
+        return;
+    triton::uint64 last = (ptr + len - 1) & ~triton::uint64(PAGE_SIZE - 1);
+    for(triton::uint64 page = ptr & ~triton::uint64(PAGE_SIZE - 1); page <= last; page += PAGE_SIZE) {
+        if(lazyPages.erase(page))
+            __loadPage(page);
+    }
+}
+
+
+/**
+ * Load a page from the spans that cover it, in the order they were added
+ * Bytes past the file size of a span, such as .bss, are zero-filled.
+ * @param page - Address of the page.
+ */
+void Swimmer::__loadPage(triton::uint64 page) {
+    for(auto& span : loadSpans) {
+        triton::uint64 lo = std::max(page, span.addr);
+        triton::uint64 hi = std::min(page + PAGE_SIZE, span.addr + span.memsz);
+        if(lo >= hi)
+            continue;
+
+        triton::uint64 fileEnd = std::max(lo, std::min(hi, span.addr + span.filesz));
+        if(lo < fileEnd)
+            setConcreteMemoryAreaValue(lo, span.data + (lo - span.addr), fileEnd - lo, false);
+        if(fileEnd < hi)
+            setConcreteMemoryAreaValue(fileEnd, std::vector<triton::uint8>(hi - fileEnd, 0), false);
+    }
+    for(auto& hole : loadHoles) {
+        triton::uint64 lo = std::max(page, hole.first);
+        triton::uint64 hi = std::min(page + PAGE_SIZE, hole.second);
+        if(lo < hi)
+            clearConcreteMemoryValue(lo, hi - lo);
+    }
+}
+
+
+/**
+ * Find the heap chunk that owns an address
+ * @param ptr - Address to query.
+ * @param strict - If true, the address must start a chunk.
+ * @return the chunk, or the end of heapAllocations if there is no owner.
+ */
+std::map<triton::uint64, Buffer>::iterator Swimmer::__findHeapChunk(triton::uint64 ptr, bool strict) {
+    if(strict)
+        return heapAllocations.find(ptr);
+    auto it = heapAllocations.upper_bound(ptr);
+    if(it == heapAllocations.begin())
+        return heapAllocations.end();
+    it--;
+    if(ptr > it->first + it->second.getSize() - 1)
+        return heapAllocations.end();
+    return it;
+}
+
+
+/**
+ * Get the size class of a heap allocation
+ * Small chunks are rounded to a power of two, and large ones to a page.
+ * A class is always larger than the allocation, so that even an exact
+ * fit is followed by a redzone to catch overflows.
+ * @param len - Length of the allocation.
+ * @return the number of bytes reserved for the allocation.
+ */
+size_t Swimmer::__heapClass(size_t len) {
+    if(len >= 0x1000)
+        return (len + 0x1000) & ~size_t(0xFFF);
+    size_t cap = 0x10;
+    while(cap <= len)
+        cap <<= 1;
+    return cap;
+}
+
+
+/**
+ * Add a stackframe to the region map
+ * A frame covers its base address down to its size below it.
+ * @param i - Index of the stackframe.
+ */
+void Swimmer::__mapFrame(size_t i) {
+    Stackframe &sf = stackframes[i];
+    if(sf.getAddress() != 0) {
+        regionMap.insert(sf.getAddress() - sf.getSize(), sf.getAddress(), RegionMap::Stack, i);
+        shadow.set(sf.getAddress() - sf.getSize(), sf.getSize() + 1, ShadowMemory::StackLocal);
+    }
+}
+
+
+/**
+ * Remove a stackframe from the region map
+ * The frames it overlapped, which it was nested within, are allocated again.
+ * @param i - Index of the stackframe.
+ */
+void Swimmer::__unmapFrame(size_t i) {
+    Stackframe &sf = stackframes[i];
+    if(sf.getAddress() != 0) {
+        triton::uint64 lo = sf.getAddress() - sf.getSize();
+        regionMap.erase(lo);
+        shadow.set(lo, sf.getSize() + 1, ShadowMemory::Unallocated);
+
+        // The frames it overlapped are still allocated
+        for(size_t j = 0; j < i; j++) {
+            Stackframe &outer = stackframes[j];
+            if(outer.getAddress() != 0 && outer.getAddress() >= lo && outer.getAddress() - outer.getSize() <= sf.getAddress())
+                shadow.set(outer.getAddress() - outer.getSize(), outer.getSize() + 1, ShadowMemory::StackLocal);
+        }
+    }
+}
+
+
+/**
+ * Push a new stackframe for a call
+ */
+void Swimmer::__pushFrame() {
+    stackframes.push_back(Stackframe());
+    FrameChange c;
+    c.kind = FramePush;
+    frameJournal.push_back(c);
+}
+
+
+/**
+ * Pop the stackframe of a returning call
+ */
+void Swimmer::__popFrame() {
+    FrameChange c;
+    c.kind = FramePop;
+    c.frame = stackframes.back();
+    frameJournal.push_back(c);
+    __unmapFrame(stackframes.size() - 1);
+    stackframes.pop_back();
+}
+
+
+/**
+ * Undo changes to the call stack, such as when a fork is resumed
+ * Changes are undone newest first, so each applies to the innermost frame.
+ * A popped or updated frame is restored from the copy journaled with it.
+ * @param n - Number of frame changes to keep.
+ */
+void Swimmer::__rewindFrames(size_t n) {
+    while(frameJournal.size() > n) {
+        FrameChange c = frameJournal.back();
+        frameJournal.pop_back();
+        switch(c.kind) {
+            case FramePush:
+                __unmapFrame(stackframes.size() - 1);
+                stackframes.pop_back();
+                break;
+            case FramePop:
+                stackframes.push_back(c.frame);
+                __mapFrame(stackframes.size() - 1);
+                break;
+            case FrameUpdate:
+                __unmapFrame(stackframes.size() - 1);
+                stackframes.back() = c.frame;
+                __mapFrame(stackframes.size() - 1);
+                break;
+            case FrameAccess:
+                stackframes.back().removeAccess(c.offs);
+                break;
+        }
+    }
+}
+
+
+/**
+ * Record memory symbolized by Koi on the current path
+ * @param ptr - Starting address of the memory.
+ * @param len - Length of the memory.
+ */
+void Swimmer::__journal(triton::uint64 ptr, size_t len) {
+    Region r;
+    r.ptr = ptr;
+    r.len = len;
+    r.heap = false;
+    regions.push_back(r);
+}
+
+
+/**
+ * Release memory symbolized by Koi on an abandoned path
+ * Regions are undone newest first. A freed chunk is made live again, and
+ * the chunks its free released are quarantined again. Each symbolized byte
+ * is concretized so Triton can free its expression, then left undefined as
+ * it was before the path. An allocated chunk is forgotten, restoring the
+ * dead chunk it reused, and its memory is returned to the free lists.
+ * @param n - Number of regions to keep.
+ */
+void Swimmer::__release(size_t n) {
+    while(regions.size() > n) {
+        Region r = regions.back();
+        regions.pop_back();
+
+        // Undo a free, returning the chunks it released to quarantine
+        if(r.freed) {
+            for(auto d = r.drained.rbegin(); d != r.drained.rend(); d++) {
+                size_t cap = __heapClass(heapAllocations.at(*d).getSize());
+                __unlistFree(*d, cap);
+                heapQuarantine.push_front(*d);
+                heapQuarantined += cap;
+                heapChunks[*d] = Quarantined;
+            }
+            if(heapChunks[r.ptr] == Quarantined) {
+                auto q = std::find(heapQuarantine.begin(), heapQuarantine.end(), r.ptr);
+                if(q != heapQuarantine.end()) {
+                    heapQuarantine.erase(q);
+                    heapQuarantined -= __heapClass(r.len);
+                }
+            }
+            heapAllocations.at(r.ptr).revive(r.sink);
+            shadow.set(r.ptr, r.len, ShadowMemory::Live);
+            heapChunks[r.ptr] = Live;
+            continue;
+        }
+
+        for(size_t i = 0; i < r.len; i++) {
+            concretizeMemory(r.ptr + i);
+            clearConcreteMemoryValue(triton::arch::MemoryAccess(r.ptr + i, 1));
+        }
+        lazyRegions.erase(r.ptr);
+        lazyRegions.insert(r.displaced.begin(), r.displaced.end());
+        if(r.heap) {
+            // Take the chunk off the quarantine or free list it may be on
+            size_t cap = __heapClass(r.len);
+            auto state = heapChunks.find(r.ptr);
+            if(state != heapChunks.end() && state->second == Quarantined) {
+                auto it = std::find(heapQuarantine.begin(), heapQuarantine.end(), r.ptr);
+                if(it != heapQuarantine.end()) {
+                    heapQuarantine.erase(it);
+                    heapQuarantined -= cap;
+                }
+            }
+            else if(state != heapChunks.end() && state->second == Free)
+                __unlistFree(r.ptr, cap);
+            heapAllocations.erase(r.ptr);
+            regionMap.erase(r.ptr);
+
+            // A reused chunk is dead and free again, a fresh one is unallocated
+            if(r.reused) {
+                heapAllocations.emplace(r.ptr, *r.reused);
+                regionMap.insert(r.ptr, r.ptr + r.reused->getSize() - 1, RegionMap::Heap, r.ptr);
+                shadow.set(r.ptr, cap, ShadowMemory::Redzone);
+                shadow.set(r.ptr, r.reused->getSize(), ShadowMemory::Freed);
+                heapFree[cap].push_back(r.ptr);
+                heapChunks[r.ptr] = Free;
+            }
+            else {
+                shadow.set(r.ptr, cap, ShadowMemory::Unallocated);
+                heapChunks.erase(r.ptr);
+                if(r.ptr + cap == heapTop)
+                    heapTop = r.ptr;
+                else
+                    heapFree[cap].push_back(r.ptr);
+            }
+        }
+    }
+}
+
+
+/**
+ * Remove a chunk from its free list, if it is listed
+ * @param ptr - Starting address of the chunk.
+ * @param cap - Size class of the chunk.
+ */
+void Swimmer::__unlistFree(triton::uint64 ptr, size_t cap) {
+    auto list = heapFree.find(cap);
+    if(list == heapFree.end())
+        return;
+    auto it = std::find(list->second.begin(), list->second.end(), ptr);
+    if(it != list->second.end())
+        list->second.erase(it);
+}
+
+
+/**
+ * Query the solver for a model, counting the outcome
+ * @param node - Constraint to solve.
+ * @param status - Where to store the status of the query (optional).
+ * @param timeout - Milliseconds before the query times out, or 0 for no limit.
+ * @return a model for the constraint, empty if not found.
+ */
+std::unordered_map<long unsigned int, triton::engines::solver::SolverModel> Swimmer::__solve(const triton::ast::SharedAbstractNode& node, triton::engines::solver::status_e *status, triton::uint32 timeout) {
+    triton::engines::solver::status_e result = triton::engines::solver::UNKNOWN;
+    setSolverMemoryLimit(solverMemoryLimit);
+    Metrics::Timer timer(__timing(), Metrics::Solver);
+    auto start = std::chrono::steady_clock::now();
+    auto model = triton::Context::getModel(node, &result, timeout);
+    metrics.addSolverTime(std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now() - start).count());
+    __countOutcome(result);
+    if(status != nullptr)
+        *status = result;
+    return model;
+}
+
+
+/**
+ * Get the metrics to time phases with
+ * @return the metrics if phases are timed, else nullptr.
+ */
+Metrics *Swimmer::__timing() {
+    return timePhases ? &metrics : nullptr;
+}
+
+
+/**
+ * Count the outcome of a solver query
+ * @param status - Status of the query.
+ * @return true if the query was not decided.
+ */
+bool Swimmer::__countOutcome(triton::engines::solver::status_e status) {
+    return metrics.countQuery(status);
+}
+
+
+/**
+ * Defer an undecided branch side until all else is explored
+ * By then the state at the fork is long gone, so the deferral keeps the
+ * branches leading to it, to be followed again from the entry.
+ * @param f - Fork of the undecided side.
+ */
+void Swimmer::__defer(Fork f) {
+    Deferral d;
+    d.branches.assign(branches.begin() + entry.nBranches, branches.begin() + f.nBranches);
+    d.decisions.assign(decisions.begin() + entry.nDecisions, decisions.begin() + f.nDecisions);
+    d.fork = f;
+    deferred.push_back(d);
+    solverStats.deferred++;
+    if(verbosity & SV_STOPS)
+        __trace(TraceSink::Deferred, f.pc);
+}
+
+
+/**
+ * Check the memory accessed by an instruction against the shadow memory
+ * Freed memory and redzones are never addressable, nor is unallocated
+ * memory within the heap. Each violating access is reported to every hook.
+ * @param pc - Address of the instruction.
+ * @param insn - Processed instruction.
+ */
+void Swimmer::__checkAccesses(triton::uint64 pc, triton::arch::Instruction& insn) {
+    const triton::uint32 poison = (1 << ShadowMemory::Freed) | (1 << ShadowMemory::Redzone);
+    for(auto *accesses : {&insn.getLoadAccess(), &insn.getStoreAccess()}) {
+        for(auto& access : *accesses) {
+            const triton::arch::MemoryAccess& mem = access.first;
+            triton::uint32 mask = poison;
+            if(isHeapAddress(mem.getAddress()))
+                mask |= 1 << ShadowMemory::Unallocated;
+
+            triton::uint64 bad;
+            if(!shadow.check(mem.getAddress(), mem.getSize(), mask, &bad))
+                continue;
+            if(verbosity & SV_ALLOC)
+                __trace(TraceSink::InvalidAccess, bad, pc);
+            __flushTrace();
+            metrics.hooksFired += accessHooks.size();
+            for(AccessHook& callback : accessHooks)
+                callback(this, pc, mem, shadow.get(bad));
+        }
+    }
+}
+
+
+/**
+ * Mark the pages of a watched range in the bitmap of watched pages
+ * Ranges reaching past the bitmap mark every page beyond it as watched.
+ * @param lo - First address of the range.
+ * @param hi - Last address of the range.
+ */
+void Swimmer::__markWatched(triton::uint64 lo, triton::uint64 hi) {
+    triton::uint64 first = lo >> 12;
+    triton::uint64 last = hi >> 12;
+    if(last >= WATCH_PAGES) {
+        watchedFar = true;
+        last = WATCH_PAGES - 1;
+    }
+    if(first > last)
+        return;
+    if(watchedPages.size() <= last)
+        watchedPages.resize(last + 1, false);
+    for(triton::uint64 p = first; p <= last; p++)
+        watchedPages[p] = true;
+}
+
+
+/**
+ * Call the watchpoints covering the memory accessed by an instruction
+ * The bitmap of watched pages filters out most accesses before any
+ * watchpoint is searched.
+ * @param pc - Address of the instruction.
+ * @param insn - Processed instruction.
+ */
+void Swimmer::__checkWatchpoints(triton::uint64 pc, triton::arch::Instruction& insn) {
+    for(bool write : {false, true}) {
+        for(auto& access : write ? insn.getStoreAccess() : insn.getLoadAccess()) {
+            const triton::arch::MemoryAccess& mem = access.first;
+            triton::uint64 lo = mem.getAddress();
+            triton::uint64 hi = lo + mem.getSize() - 1;
+
+            // Skip accesses to pages without a watchpoint
+            bool watched = false;
+            for(triton::uint64 p = lo >> 12; p <= (hi >> 12) && !watched; p++)
+                watched = p < watchedPages.size() ? watchedPages[p] : (p >= WATCH_PAGES && watchedFar);
+            if(!watched)
+                continue;
+
+            // Hooks may add or remove watchpoints, so iterate over copies
+            __flushTrace();
+            for(size_t i = 0; i < watchpoints.size(); i++) {
+                Watchpoint w = watchpoints[i];
+                if(lo <= w.hi && hi >= w.lo && (write ? w.write : w.read)) {
+                    metrics.hooksFired++;
+                    w.callback(this, pc, mem, write);
+                }
+            }
+        }
+    }
+}
+
+
 /**
  * Print the values of concrete registers and note symbolic registers
  * @param all - Print all registers, not only general purpose
  */
 void Swimmer::__printRegisters(bool all) {
+    // Records traced before the registers must be printed first
+    __flushTrace();
+
     // All printing in this function should be hexadecimal
     std::cout << std::hex;
 
@@ -929,10 +2513,10 @@ void Swimmer::__printRegisters(bool all) {
             triton::uint64 val = triton::uint64(getConcreteRegisterValue(reg));
             std::cout << " = 0x" << val;
 
-            // Continually print memory pointers until not concrete
+            // Continually print memory pointers until not concrete, without symbolizing lazy memory
             triton::arch::MemoryAccess ptr = triton::arch::MemoryAccess(val, 8);
             while(!isMemorySymbolized(ptr) && isConcreteMemoryValueDefined(ptr)) {
-                val = triton::uint64(getConcreteMemoryValue(ptr));
+                val = triton::uint64(getConcreteMemoryValue(ptr, false));
                 if(val == ptr.getAddress()) break;
                 std::cout << " -> 0x" << val;
                 ptr = triton::arch::MemoryAccess(val, 8);
@@ -952,3 +2536,27 @@ void Swimmer::__printRegisters(bool all) {
     std::cout << std::dec;
     return;
 }
+
+
+/**
+ * Add a record of the current path to the trace sink, creating it if needed
+ * Callers check the verbosity first, so nothing is recorded when quiet.
+ * @param kind - Kind of the record.
+ * @param a - First value of the record (default=0).
+ * @param b - Second value of the record (default=0).
+ * @param text - Text of the record (default=nullptr).
+ */
+void Swimmer::__trace(TraceSink::RecordKind kind, triton::uint64 a, triton::uint64 b, const char *text) {
+    if(!traceSink)
+        traceSink = std::make_shared<TraceSink>();
+    traceSink->push(kind, a, b, pathFid, depth, text);
+}
+
+
+/**
+ * Wait until the trace sink has written every record, if there is one
+ */
+void Swimmer::__flushTrace() {
+    if(traceSink)
+        traceSink->flush();
+}
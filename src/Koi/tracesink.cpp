@@ -0,0 +1,223 @@
+#include <chrono>
+#include <cstring>
+#include <iomanip>
+#include <iostream>
+#include <triton/context.hpp>
+#include "Koi/tracesink.h"
+
+
+/********************/
+/* PUBLIC FUNCTIONS */
+/********************/
+
+
+/**
+ * Constructor
+ * @param w - Writer for each record (default=TraceSink::print).
+ * @param capacity - Records the ring buffer holds, rounded up to a power of two (default=4096).
+ * @return a new TraceSink
+ */
+TraceSink::TraceSink(Writer w, size_t capacity) : dropped(0), head(0), reported(0), sleeping(false), stopping(false), tail(0), writer(w) {
+    size_t n = 1;
+    while(n < capacity)
+        n <<= 1;
+    ring.resize(n);
+    mask = n - 1;
+    printer = std::thread(&TraceSink::__print, this);
+}
+
+
+/**
+ * Destructor, writing the records that are left.
+ */
+TraceSink::~TraceSink() {
+    flush();
+    {
+        std::lock_guard<std::mutex> guard(lock);
+        stopping = true;
+    }
+    wake.notify_one();
+    printer.join();
+}
+
+
+/**
+ * Add a record without blocking, dropping it if the ring buffer is full.
+ * Only one thread may add records. The background thread is only woken
+ * if it went to sleep on an empty ring buffer.
+ * @param kind - Kind of the record.
+ * @param a - First value of the record (default=0).
+ * @param b - Second value of the record (default=0).
+ * @param fid - Fork ID of the path (default=0).
+ * @param depth - Depth of the path (default=0).
+ * @param text - Text of the record, truncated to fit (default=nullptr).
+ */
+void TraceSink::push(RecordKind kind, triton::uint64 a, triton::uint64 b, uint fid, uint depth, const char *text) {
+    size_t t = tail.load(std::memory_order_relaxed);
+    if(t - head.load(std::memory_order_acquire) > mask) {
+        dropped.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+
+    Record &r = ring[t & mask];
+    r.kind = kind;
+    r.fid = fid;
+    r.depth = depth;
+    r.a = a;
+    r.b = b;
+    r.text[0] = '\0';
+    if(text != nullptr) {
+        strncpy(r.text, text, sizeof(r.text) - 1);
+        r.text[sizeof(r.text) - 1] = '\0';
+    }
+    tail.store(t + 1);
+    if(sleeping.load()) {
+        std::lock_guard<std::mutex> guard(lock);
+        wake.notify_one();
+    }
+}
+
+
+/**
+ * Wait until every record added so far has been written, then report any newly dropped records.
+ * Drops are reported through the writer as a Dropped record, so a trace
+ * never silently skips records.
+ */
+void TraceSink::flush() {
+    while(true) {
+        size_t t = tail.load(std::memory_order_relaxed);
+        while(head.load(std::memory_order_acquire) != t)
+            std::this_thread::yield();
+
+        // The ring buffer is empty, so the report always fits
+        triton::uint64 d = getDropped();
+        if(d == reported)
+            return;
+        push(Dropped, d - reported);
+        reported = d;
+    }
+}
+
+
+/**
+ * Get the number of records dropped because the ring buffer was full.
+ * @return the number of dropped records.
+ */
+triton::uint64 TraceSink::getDropped() {
+    return dropped.load(std::memory_order_relaxed);
+}
+
+
+/**
+ * Write a record as ANSI-coloured text to stdout.
+ * Lines end without flushing, since stdout is flushed as it fills.
+ * @param r - Record to write.
+ */
+void TraceSink::print(const Record& r) {
+    std::ostream &out = std::cout;
+    out << std::hex;
+    switch(r.kind) {
+        case Insn:
+            out << std::dec << "[" << r.fid << "] (" << r.depth << ") " << std::hex << "0x" << r.a << ": " << r.text;
+            break;
+        case FuncHook:
+            out << std::dec << "[" << r.fid << "] (" << r.depth << ") 0x------  [func hook]";
+            break;
+        case StepOver:
+            out << std::dec << "[" << r.fid << "] (" << r.depth << ") 0x------  [step over]";
+            break;
+        case Branch:
+            out << "\033[1m" << (r.b ? "JUMP" : "FALL") << " from 0x" << r.a << "\033[0m";
+            break;
+        case Alloc:
+            out << "\033[1mAllocated " << std::dec << r.b << std::hex << " bytes @ 0x" << r.a << "\033[0m";
+            break;
+        case Free:
+            out << "\033[1mFreeing pointer @ 0x" << r.a << "\033[0m";
+            break;
+        case Frame:
+            out << "\033[1mIdentified stackframe @ 0x" << r.a << " has 0x" << r.b << " bytes\033[0m";
+            break;
+        case FrameAccess:
+            out << "\033[1mNew access to stackframe @ 0x" << r.a << "\033[0m";
+            break;
+        case FrameEnd:
+            out << "\033[1mEnd of stackframe\033[0m";
+            break;
+        case Exhausted:
+            out << "\033[31mExhausted 0x" << r.a << "\033[0m";
+            break;
+        case Undefined:
+            out << "\033[31mUndefined: 0x" << r.a << "\033[0m";
+            break;
+        case NotExecutable:
+            out << "\033[31mNot executable: 0x" << r.a << "\033[0m";
+            break;
+        case Target:
+            out << "\033[32mTarget Reached\033[0m";
+            break;
+        case TargetAt:
+            out << "\033[32mTarget 0x" << r.a << " Reached\033[0m";
+            break;
+        case DeadEnd:
+            out << "\033[31mDead End Reached\033[0m";
+            break;
+        case PathEnd:
+            out << "\033[31mEnd of Path Reached\033[0m";
+            break;
+        case TooDeep:
+            out << "\033[31mToo deep to fork\033[0m";
+            break;
+        case SpeculationFailed:
+            out << "\033[31mSpeculation Failed @ 0x" << r.a << "\033[0m";
+            break;
+        case Concretized:
+            out << "\033[33mConcretized oversized expression @ 0x" << r.a << "\033[0m";
+            break;
+        case Deferred:
+            out << "\033[33mDeferred 0x" << r.a << "\033[0m";
+            break;
+        case InvalidAccess:
+            out << "\033[31mInvalid access @ 0x" << r.a << " from 0x" << r.b << "\033[0m";
+            break;
+        case Compacted:
+            out << "\033[1mCompacted " << std::dec << r.a << " expressions\033[0m";
+            break;
+        case Dropped:
+            out << "\033[33mDropped " << std::dec << r.a << " trace records\033[0m";
+            break;
+    }
+    out << std::dec << "\n";
+}
+
+
+/*********************/
+/* PRIVATE FUNCTIONS */
+/*********************/
+
+
+/**
+ * Write records as they arrive until stopped
+ * The thread announces that it is sleeping before checking the ring buffer
+ * a last time, so a record added meanwhile either is seen or wakes it.
+ */
+void TraceSink::__print() {
+    while(true) {
+        size_t h = head.load(std::memory_order_relaxed);
+        size_t t = tail.load(std::memory_order_acquire);
+        for(; h != t; h++) {
+            writer(ring[h & mask]);
+            head.store(h + 1, std::memory_order_release);
+        }
+        std::cout.flush();
+
+        std::unique_lock<std::mutex> guard(lock);
+        sleeping = true;
+        if(tail.load() == h) {
+            if(stopping)
+                return;
+            wake.wait(guard);
+        }
+        sleeping = false;
+    }
+}
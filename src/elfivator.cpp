@@ -4,11 +4,80 @@
 #include <libelf.h>
 #include <gelf.h>
 #include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
 #include <unistd.h>
 #include <iomanip>
+#include <cstring>
+#include <map>
+#include <mutex>
+#include <sstream>
 #include "elfivator.h"
 
 
+/********************/
+/* HELPER FUNCTIONS */
+/********************/
+
+
+/* Snapshots begin with a magic number that includes the format version */
+static const char SNAPSHOT_MAGIC[8] = {'K', 'O', 'I', 'S', 'N', 'A', 'P', 2};
+
+
+/**
+ * Write an integer to a snapshot.
+ * @param out - Stream to write to.
+ * @param v - Integer to write.
+ */
+static void putU64(std::ostream& out, uint64_t v) {
+    out.write((const char *)&v, sizeof(v));
+}
+
+
+/**
+ * Write a length-prefixed string to a snapshot.
+ * @param out - Stream to write to.
+ * @param s - String to write.
+ */
+static void putString(std::ostream& out, const std::string& s) {
+    putU64(out, s.size());
+    out.write(s.data(), s.size());
+}
+
+
+/**
+ * Read an integer from a snapshot.
+ * @param p - Cursor into the snapshot, advanced past the integer.
+ * @param end - End of the snapshot.
+ * @param v - Where to store the integer.
+ * @return true if the integer was within the snapshot.
+ */
+static bool getU64(const unsigned char *&p, const unsigned char *end, uint64_t *v) {
+    if(end - p < (ptrdiff_t)sizeof(*v))
+        return false;
+    memcpy(v, p, sizeof(*v));
+    p += sizeof(*v);
+    return true;
+}
+
+
+/**
+ * Read a length-prefixed string from a snapshot.
+ * @param p - Cursor into the snapshot, advanced past the string.
+ * @param end - End of the snapshot.
+ * @param s - Where to store the string.
+ * @return true if the string was within the snapshot.
+ */
+static bool getString(const unsigned char *&p, const unsigned char *end, std::string *s) {
+    uint64_t len;
+    if(!getU64(p, end, &len) || (uint64_t)(end - p) < len)
+        return false;
+    s->assign((const char *)p, len);
+    p += len;
+    return true;
+}
+
+
 /********************/
 /* PUBLIC FUNCTIONS */
 /********************/
@@ -16,11 +85,66 @@
 
 /**
  * Constructor
+ * With a snapshot directory, the parsed file is read from the snapshot of
+ * its hash if there is one, else parsed and then written as a snapshot.
  * @param filein - Path to a file to load.
+ * @param snapshotDir - Directory of snapshots, or empty to always parse (default="").
  * @return a new Elfivator
  */
-Elfivator::Elfivator(const std::string& filein) {
+Elfivator::Elfivator(const std::string& filein, const std::string& snapshotDir) {
+    if(!mapFile(filein))
+        return;
+    if(snapshotDir.empty()) {
+        readElfFile(filein);
+        return;
+    }
+
+    // Only snapshots are keyed by the hash, so only they pay for it
+    hash = hashImage();
+    std::stringstream ss;
+    ss << snapshotDir << "/" << std::hex << std::setw(16) << std::setfill('0') << hash << ".koi";
+    if(readSnapshot(ss.str()))
+        return;
     readElfFile(filein);
+    writeSnapshot(ss.str());
+}
+
+
+/**
+ * Get the image of a file shared by every user in the process, loading it if needed.
+ * Images are identified by the file's device, inode, size and modification
+ * time, and are unmapped once their last user releases them.
+ * @param filein - Path to a file to load.
+ * @param snapshotDir - Directory of snapshots, or empty to always parse (default="").
+ * @return the shared, read-only image of the file.
+ */
+std::shared_ptr<const Elfivator> Elfivator::share(const std::string& filein, const std::string& snapshotDir) {
+    static std::mutex lock;
+    static std::map<std::string, std::weak_ptr<const Elfivator>> images;
+
+    // Files that cannot be identified are never shared
+    struct stat st;
+    if (stat(filein.c_str(), &st) == -1)
+        return std::make_shared<const Elfivator>(filein, snapshotDir);
+    std::stringstream key;
+    key << st.st_dev << ":" << st.st_ino << ":" << st.st_size << ":" << st.st_mtime;
+
+    std::lock_guard<std::mutex> guard(lock);
+    std::shared_ptr<const Elfivator> e = images[key.str()].lock();
+    if (!e) {
+        e = std::make_shared<const Elfivator>(filein, snapshotDir);
+        images[key.str()] = e;
+    }
+    return e;
+}
+
+
+/**
+ * Destructor, unmapping the file.
+ */
+Elfivator::~Elfivator() {
+    if(image != nullptr)
+        munmap(image, imageSize);
 }
 
 
@@ -29,6 +153,53 @@ Elfivator::Elfivator(const std::string& filein) {
 /**********************/
 
 
+/**
+ * Map a file into memory, so its sections can be read in place.
+ * @param filein - Path to the file to map.
+ * @return true if the file was mapped.
+ */
+bool Elfivator::mapFile(const std::string& filein) {
+    // Open the ELF file
+    int fd = open(filein.c_str(), O_RDONLY);
+    if (fd == -1) {
+        std::cerr << "Failed to open ELF file: " << filein << std::endl;
+        return false;
+    }
+
+    // Map the whole file, which stays mapped once the file is closed
+    struct stat st;
+    if (fstat(fd, &st) == -1 || st.st_size == 0) {
+        std::cerr << "Failed to stat ELF file: " << filein << std::endl;
+        close(fd);
+        return false;
+    }
+    image = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (image == MAP_FAILED) {
+        std::cerr << "Failed to map ELF file: " << filein << std::endl;
+        image = nullptr;
+        return false;
+    }
+    imageSize = st.st_size;
+    return true;
+}
+
+
+/**
+ * Hash the mapped file with 64-bit FNV-1a.
+ * @return the hash of the file.
+ */
+uint64_t Elfivator::hashImage() {
+    uint64_t h = 0xcbf29ce484222325;
+    const unsigned char *bytes = (const unsigned char *)image;
+    for(size_t i = 0; i < imageSize; i++) {
+        h ^= bytes[i];
+        h *= 0x100000001b3;
+    }
+    return h;
+}
+
+
 /**
  * Parse an ELF file for its important sections.
  * @param filein - Path to ELF file to parse.
@@ -40,17 +211,10 @@ void Elfivator::readElfFile(const std::string& filein) {
         return;
     }
 
-    // Open the ELF file
-    int fd = open(filein.c_str(), O_RDONLY);
-    if (fd == -1) {
-        std::cerr << "Failed to open ELF file: " << filein << std::endl;
-        return;
-    }
-
-    // Initialize ELF descriptor
-    Elf *e = elf_begin(fd, ELF_C_READ, nullptr);
+    // Initialize ELF descriptor over the mapping
+    Elf *e = elf_memory((char *)image, imageSize);
     if (!e) {
-        std::cerr << "Failed to read ELF header: " << elf_errmsg(-1) << std::endl;
+        std::cerr << "Failed to read ELF header of " << filein << ": " << elf_errmsg(-1) << std::endl;
         return;
     }
 
@@ -58,11 +222,34 @@ void Elfivator::readElfFile(const std::string& filein) {
     GElf_Ehdr ehdr;
     if (gelf_getehdr(e, &ehdr) == nullptr) {
         std::cerr << "Failed to get ELF header: " << elf_errmsg(-1) << std::endl;
+        elf_end(e);
         return;
     }
 
-    // Fetch the entry point address
+    // Fetch the entry point address, relative to the load base if position independent
     entry = ehdr.e_entry;
+    pie = ehdr.e_type == ET_DYN;
+
+    // Iterate over program headers to find the loadable segments
+    size_t nPhdrs = 0;
+    elf_getphdrnum(e, &nPhdrs);
+    for (size_t i = 0; i < nPhdrs; i++) {
+        GElf_Phdr phdr;
+        if (gelf_getphdr(e, i, &phdr) == nullptr || phdr.p_type != PT_LOAD)
+            continue;
+
+        // File bytes past the end of the file are left to be zero-filled
+        bool inFile = phdr.p_offset <= imageSize && phdr.p_filesz <= imageSize - phdr.p_offset;
+        size_t filesz = inFile ? phdr.p_filesz : 0;
+        ElfSegment segment = {
+            (const unsigned char *)image + phdr.p_offset,
+            phdr.p_vaddr,
+            filesz,
+            phdr.p_memsz,
+            phdr.p_flags
+        };
+        segments.push_back(segment);
+    }
 
     // Iterate over sections to find the .text section
     Elf_Scn *scn = nullptr;
@@ -70,28 +257,254 @@ void Elfivator::readElfFile(const std::string& filein) {
     while ((scn = elf_nextscn(e, scn)) != nullptr) {
         gelf_getshdr(scn, &shdr);
 
-        // Check if the section has bits
-        if(!(shdr.sh_type & SHT_NOBITS)) {
-            Elf_Data *data = elf_getdata(scn, nullptr);
+        // Check if the section has bits within the file
+        if(shdr.sh_type != SHT_NOBITS && shdr.sh_offset <= imageSize && shdr.sh_size <= imageSize - shdr.sh_offset) {
             const char *sectionName = elf_strptr(e, ehdr.e_shstrndx, shdr.sh_name);
 
-            // Begrudingly copy the bytes to a vector
-            std::vector<unsigned char> dataVec;
-            for (size_t i = 0; i < data->d_size; i++)
-                dataVec.push_back(((unsigned char *)data->d_buf)[i]);
-
-            // Save important information
+            // Save important information, pointing into the mapping
             ElfSection section = {
-                dataVec,
+                (const unsigned char *)image + shdr.sh_offset,
                 std::string(sectionName),
                 shdr.sh_addr,
-                data->d_size
+                shdr.sh_size,
+                shdr.sh_flags
             };
             sections.push_back(section);
         }
     }
 
+    // Resolve functions by name
+    readSymbols();
+    readImports();
+
     // Clean up
     elf_end(e);
+}
+
+
+/**
+ * Find a section by name
+ * @param name - Name of the section.
+ * @return the section, or nullptr if there is none.
+ */
+const Elfivator::ElfSection *Elfivator::findSection(const std::string& name) {
+    for(const ElfSection& section : sections) {
+        if(section.name == name)
+            return &section;
+    }
+    return nullptr;
+}
+
+
+/**
+ * Parse the function symbols defined by the symbol tables
+ */
+void Elfivator::readSymbols() {
+    const std::pair<const char *, const char *> tables[] = {
+        {".symtab", ".strtab"},
+        {".dynsym", ".dynstr"},
+    };
+    for(auto& table : tables) {
+        const ElfSection *symtab = findSection(table.first);
+        const ElfSection *strtab = findSection(table.second);
+        if(symtab == nullptr || strtab == nullptr)
+            continue;
+
+        // Keep defined functions, with a name in bounds
+        const Elf64_Sym *syms = (const Elf64_Sym *)symtab->data;
+        for(size_t i = 0; i < symtab->size / sizeof(Elf64_Sym); i++) {
+            if(ELF64_ST_TYPE(syms[i].st_info) != STT_FUNC || syms[i].st_shndx == SHN_UNDEF)
+                continue;
+            if(syms[i].st_name >= strtab->size)
+                continue;
+            symbols.emplace(std::string((const char *)strtab->data + syms[i].st_name), syms[i].st_value);
+        }
+    }
+}
+
+
+/**
+ * Parse the PLT stubs of imported functions
+ * Relocations name the GOT slot of each import, and each stub is found by
+ * the indirect jump through its slot, "jmp *disp(%rip)" (ff 25 disp32).
+ */
+void Elfivator::readImports() {
+    const ElfSection *dynsym = findSection(".dynsym");
+    const ElfSection *dynstr = findSection(".dynstr");
+    if(dynsym == nullptr || dynstr == nullptr)
+        return;
+
+    // Name the GOT slots of imported functions
+    std::unordered_map<size_t, std::string> slots;
+    const Elf64_Sym *syms = (const Elf64_Sym *)dynsym->data;
+    size_t nSyms = dynsym->size / sizeof(Elf64_Sym);
+    for(const char *name : {".rela.plt", ".rela.dyn"}) {
+        const ElfSection *rela = findSection(name);
+        if(rela == nullptr)
+            continue;
+        const Elf64_Rela *relocs = (const Elf64_Rela *)rela->data;
+        for(size_t i = 0; i < rela->size / sizeof(Elf64_Rela); i++) {
+            size_t type = ELF64_R_TYPE(relocs[i].r_info);
+            size_t sym = ELF64_R_SYM(relocs[i].r_info);
+            if((type != R_X86_64_JUMP_SLOT && type != R_X86_64_GLOB_DAT) || sym == 0 || sym >= nSyms)
+                continue;
+            if(syms[sym].st_name >= dynstr->size)
+                continue;
+            slots.emplace(relocs[i].r_offset, std::string((const char *)dynstr->data + syms[sym].st_name));
+        }
+    }
+
+    // Find the stub that jumps through each slot, preferring .plt.sec when present
+    const unsigned char endbr64[] = {0xf3, 0x0f, 0x1e, 0xfa};
+    for(const char *name : {".plt.sec", ".plt", ".plt.got"}) {
+        const ElfSection *plt = findSection(name);
+        if(plt == nullptr)
+            continue;
+        for(size_t i = 0; i + 6 <= plt->size; i++) {
+            if(plt->data[i] != 0xff || plt->data[i+1] != 0x25)
+                continue;
+            int32_t disp;
+            memcpy(&disp, plt->data + i + 2, sizeof(disp));
+            auto slot = slots.find(plt->offset + i + 6 + disp);
+            if(slot == slots.end())
+                continue;
+
+            // The stub begins at its bnd prefix and endbr64, if it has them
+            size_t stub = i;
+            if(stub >= 1 && plt->data[stub-1] == 0xf2)
+                stub--;
+            if(stub >= 4 && memcmp(plt->data + stub - 4, endbr64, sizeof(endbr64)) == 0)
+                stub -= 4;
+            imports.emplace(slot->second, plt->offset + stub);
+            i += 5;
+        }
+    }
+}
+
+
+
+/**
+ * Read the parsed file from a snapshot
+ * The snapshot must match the hash and size of the mapped file. Sections
+ * and segments are stored as offsets into the file, so they still point
+ * into its mapping.
+ * @param path - Path to the snapshot.
+ * @return true if the snapshot was read.
+ */
+bool Elfivator::readSnapshot(const std::string& path) {
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd == -1)
+        return false;
+    struct stat st;
+    if (fstat(fd, &st) == -1 || st.st_size == 0) {
+        close(fd);
+        return false;
+    }
+    void *snapshot = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
     close(fd);
+    if (snapshot == MAP_FAILED)
+        return false;
+
+    // Parse into temporaries, so a bad snapshot leaves nothing behind
+    const unsigned char *p = (const unsigned char *)snapshot;
+    const unsigned char *end = p + st.st_size;
+    const unsigned char *base = (const unsigned char *)image;
+    std::vector<ElfSection> snapSections;
+    std::vector<ElfSegment> snapSegments;
+    std::unordered_map<std::string, size_t> snapImports, snapSymbols;
+    uint64_t snapHash, snapSize, snapEntry, snapPie, counts[4];
+    bool ok = end - p >= (ptrdiff_t)sizeof(SNAPSHOT_MAGIC) && memcmp(p, SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC)) == 0;
+    if(ok) {
+        p += sizeof(SNAPSHOT_MAGIC);
+        ok = getU64(p, end, &snapHash) && getU64(p, end, &snapSize)
+          && getU64(p, end, &snapEntry) && getU64(p, end, &snapPie)
+          && getU64(p, end, &counts[0]) && getU64(p, end, &counts[1])
+          && getU64(p, end, &counts[2]) && getU64(p, end, &counts[3])
+          && snapHash == hash && snapSize == imageSize;
+    }
+    for(uint64_t i = 0; ok && i < counts[0]; i++) {
+        uint64_t addr, offset, size, flags;
+        std::string name;
+        ok = getU64(p, end, &addr) && getU64(p, end, &offset) && getU64(p, end, &size)
+          && getU64(p, end, &flags) && getString(p, end, &name) && offset <= imageSize && size <= imageSize - offset;
+        if(ok)
+            snapSections.push_back({base + offset, name, addr, size, flags});
+    }
+    for(uint64_t i = 0; ok && i < counts[1]; i++) {
+        uint64_t vaddr, offset, filesz, memsz, flags;
+        ok = getU64(p, end, &vaddr) && getU64(p, end, &offset) && getU64(p, end, &filesz)
+          && getU64(p, end, &memsz) && getU64(p, end, &flags) && offset <= imageSize && filesz <= imageSize - offset;
+        if(ok)
+            snapSegments.push_back({base + offset, vaddr, filesz, memsz, (unsigned int)flags});
+    }
+    for(int t = 2; t < 4; t++) {
+        for(uint64_t i = 0; ok && i < counts[t]; i++) {
+            uint64_t value;
+            std::string name;
+            ok = getU64(p, end, &value) && getString(p, end, &name);
+            if(ok)
+                (t == 2 ? snapImports : snapSymbols).emplace(name, value);
+        }
+    }
+    munmap(snapshot, st.st_size);
+    if(!ok)
+        return false;
+
+    entry = snapEntry;
+    pie = snapPie != 0;
+    sections = std::move(snapSections);
+    segments = std::move(snapSegments);
+    imports = std::move(snapImports);
+    symbols = std::move(snapSymbols);
+    return true;
+}
+
+
+/**
+ * Write the parsed file as a snapshot
+ * The snapshot is written to a temporary file and renamed into place, so
+ * that concurrent readers never see a partial snapshot.
+ * @param path - Path to the snapshot.
+ */
+void Elfivator::writeSnapshot(const std::string& path) {
+    std::stringstream tmp;
+    tmp << path << ".tmp" << getpid();
+    std::ofstream out(tmp.str(), std::ios::binary | std::ios::trunc);
+    if(!out)
+        return;
+
+    const unsigned char *base = (const unsigned char *)image;
+    out.write(SNAPSHOT_MAGIC, sizeof(SNAPSHOT_MAGIC));
+    putU64(out, hash);
+    putU64(out, imageSize);
+    putU64(out, entry);
+    putU64(out, pie);
+    putU64(out, sections.size());
+    putU64(out, segments.size());
+    putU64(out, imports.size());
+    putU64(out, symbols.size());
+    for(const ElfSection& section : sections) {
+        putU64(out, section.offset);
+        putU64(out, section.data - base);
+        putU64(out, section.size);
+        putU64(out, section.flags);
+        putString(out, section.name);
+    }
+    for(const ElfSegment& segment : segments) {
+        putU64(out, segment.vaddr);
+        putU64(out, segment.data - base);
+        putU64(out, segment.filesz);
+        putU64(out, segment.memsz);
+        putU64(out, segment.flags);
+    }
+    for(auto *table : {&imports, &symbols}) {
+        for(auto& pair : *table) {
+            putU64(out, pair.second);
+            putString(out, pair.first);
+        }
+    }
+
+    out.close();
+    if(out.fail() || rename(tmp.str().c_str(), path.c_str()) != 0)
+        unlink(tmp.str().c_str());
 }
@@ -0,0 +1,108 @@
+#include <cstring>
+#include <filesystem>
+#include <string>
+#include <vector>
+#include "elfivator.h"
+#include "test.h"
+
+
+/**
+ * Check that two images parsed the same file alike.
+ * @param a - First image.
+ * @param b - Second image.
+ * @return true if the images have the same sections, segments, imports and symbols.
+ */
+static bool sameImage(const Elfivator& a, const Elfivator& b) {
+    if(a.entry != b.entry || a.pie != b.pie || a.imports != b.imports || a.symbols != b.symbols
+    || a.sections.size() != b.sections.size() || a.segments.size() != b.segments.size())
+        return false;
+    for(size_t i = 0; i < a.sections.size(); i++) {
+        auto& x = a.sections[i];
+        auto& y = b.sections[i];
+        if(x.name != y.name || x.offset != y.offset || x.size != y.size || x.flags != y.flags)
+            return false;
+        if((x.data == nullptr) != (y.data == nullptr))
+            return false;
+        if(x.data != nullptr && memcmp(x.data, y.data, x.size) != 0)
+            return false;
+    }
+    for(size_t i = 0; i < a.segments.size(); i++) {
+        auto& x = a.segments[i];
+        auto& y = b.segments[i];
+        if(x.vaddr != y.vaddr || x.filesz != y.filesz || x.memsz != y.memsz || x.flags != y.flags)
+            return false;
+        if(x.filesz > 0 && memcmp(x.data, y.data, x.filesz) != 0)
+            return false;
+    }
+    return true;
+}
+
+
+/**
+ * Get the snapshots in a directory.
+ * @param dir - Directory of snapshots.
+ * @return the paths of the snapshots.
+ */
+static std::vector<std::filesystem::path> snapshots(const std::string& dir) {
+    std::vector<std::filesystem::path> files;
+    for(auto& entry : std::filesystem::directory_iterator(dir))
+        files.push_back(entry.path());
+    return files;
+}
+
+
+/**
+ * A snapshot is written on the first load, then read back as the same image.
+ * @param file - File to load.
+ * @param dir - Directory for the snapshots.
+ */
+static void testSnapshot(const std::string& file, const std::string& dir) {
+    std::filesystem::remove_all(dir);
+    std::filesystem::create_directories(dir);
+    Elfivator parsed(file);
+    CHECK(!parsed.sections.empty());
+    CHECK(parsed.symbols.count("classify"));
+    CHECK(parsed.hash == 0);
+
+    // The first load writes the snapshot, keyed by the hash of the file
+    Elfivator written(file, dir);
+    CHECK(written.hash != 0);
+    CHECK(sameImage(parsed, written));
+    std::vector<std::filesystem::path> files = snapshots(dir);
+    CHECK(files.size() == 1);
+
+    // The second load reads it
+    Elfivator read(file, dir);
+    CHECK(read.hash == written.hash);
+    CHECK(sameImage(parsed, read));
+
+    // A truncated snapshot is parsed again, and rewritten
+    if(files.size() == 1) {
+        auto size = std::filesystem::file_size(files[0]);
+        std::filesystem::resize_file(files[0], size / 2);
+        Elfivator reparsed(file, dir);
+        CHECK(sameImage(parsed, reparsed));
+        CHECK(std::filesystem::file_size(files[0]) == size);
+    }
+    std::filesystem::remove_all(dir);
+}
+
+
+/**
+ * An image is shared while it is in use.
+ * @param file - File to load.
+ */
+static void testShare(const std::string& file) {
+    auto a = Elfivator::share(file);
+    auto b = Elfivator::share(file);
+    CHECK(a == b);
+    CHECK(a->symbols.count("classify"));
+}
+
+
+int main(int argc, char *argv[]) {
+    std::string dir = argc > 1 ? argv[1] : "build/tests";
+    testSnapshot(dir + "/input_exe/branches", dir + "/snapshots");
+    testShare(dir + "/input_exe/branches");
+    return testResult("elfivator");
+}
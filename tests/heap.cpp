@@ -0,0 +1,91 @@
+#include <string>
+#include <triton/context.hpp>
+#include "Koi/swimmer.h"
+#include "test.h"
+
+
+/**
+ * Chunks are reserved by size class, leaving room for a redzone after an exact fit.
+ * @param s - Swimmer with an empty heap.
+ */
+static void testSizeClasses(Swimmer& s) {
+    triton::uint64 a = s.allocateHeapMemory("a", 0, 1);
+    triton::uint64 b = s.allocateHeapMemory("b", 0, 0x10);
+    triton::uint64 c = s.allocateHeapMemory("c", 0, 0x11);
+    triton::uint64 d = s.allocateHeapMemory("d", 0, 0x1000);
+    triton::uint64 e = s.allocateHeapMemory("e", 0, 1);
+    CHECK(a == Swimmer::HEAP_START);
+    CHECK(b == a + 0x10);
+    CHECK(c == b + 0x20);
+    CHECK(d == c + 0x20);
+    CHECK(e == d + 0x2000);
+    CHECK(s.allocateHeapMemory("empty", 0, 0) == 0);
+
+    // A chunk is found from any of its bytes, but not its redzone
+    CHECK(s.statHeapMemory(b + 0xf));
+    CHECK(!s.statHeapMemory(b + 0xf, true));
+    CHECK(!s.statHeapMemory(a + 0x1));
+    CHECK(s.getBufferAlias(d) != "UNDEFINED");
+}
+
+
+/**
+ * Freed chunks are quarantined, and only reused once the quarantine overflows, oldest first.
+ * @param s - Swimmer with an empty heap.
+ */
+static void testQuarantine(Swimmer& s) {
+    s.heapQuarantineSize = 0x40;
+    triton::uint64 a = s.allocateHeapMemory("a", 0, 0x18);
+    triton::uint64 b = s.allocateHeapMemory("b", 0, 0x18);
+    triton::uint64 c = s.allocateHeapMemory("c", 0, 0x18);
+
+    // A free chunk is dead, and cannot be freed twice or from within
+    CHECK(!s.freeHeapMemory(a + 1, 0x401000));
+    CHECK(s.freeHeapMemory(a, 0x401000));
+    CHECK(!s.statHeapMemory(a));
+    CHECK(s.getHeapSink(a) == 0x401000);
+    CHECK(!s.freeHeapMemory(a, 0x401004));
+    CHECK(!s.freeHeapMemory(0x1234, 0x401004));
+
+    // The quarantine still holds the chunk, so fresh memory is taken
+    triton::uint64 d = s.allocateHeapMemory("d", 0, 0x18);
+    CHECK(d != a);
+    CHECK(d == c + 0x20);
+
+    // A third chunk overflows the quarantine, so the oldest is reused
+    CHECK(s.freeHeapMemory(b, 0x401008));
+    CHECK(s.freeHeapMemory(c, 0x40100c));
+    triton::uint64 e = s.allocateHeapMemory("e", 0, 0x10);
+    CHECK(e == a);
+    CHECK(s.statHeapMemory(e));
+    CHECK(!s.statHeapMemory(b));
+
+    // Another size class is never reused
+    triton::uint64 f = s.allocateHeapMemory("f", 0, 0x30);
+    CHECK(f != b && f != c);
+}
+
+
+/**
+ * Without a quarantine, a freed chunk is reused by the next allocation of its class.
+ * @param s - Swimmer with an empty heap.
+ */
+static void testNoQuarantine(Swimmer& s) {
+    s.heapQuarantineSize = 0;
+    triton::uint64 a = s.allocateHeapMemory("a", 0, 0x100);
+    CHECK(s.freeHeapMemory(a, 0x401000));
+    CHECK(s.allocateHeapMemory("b", 0, 0x1ff) == a);
+    CHECK(s.statHeapMemory(a));
+}
+
+
+int main(int argc, char *argv[]) {
+    std::string dir = argc > 1 ? argv[1] : "build/tests";
+    Swimmer s(dir + "/input_exe/branches");
+    testSizeClasses(s);
+    s.reset();
+    testQuarantine(s);
+    s.reset();
+    testNoQuarantine(s);
+    return testResult("heap");
+}
@@ -0,0 +1,20 @@
+/* Symbolic branches for the exploration tests, reached with a symbolic argument */
+
+
+/* A branch that cannot be taken comes before the first fork */
+int classify(int x) {
+    // Halving clears the top bit, so only the fallthrough is feasible
+    if(((unsigned)x >> 1) == 0x80000000u)
+        return -1;
+
+    // Both sides are feasible, so the path forks here
+    if(x > 10)
+        return 1;
+    return 0;
+}
+
+
+int main(int argc, char *argv[]) {
+    (void)argv;
+    return classify(argc);
+}
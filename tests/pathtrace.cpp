@@ -0,0 +1,138 @@
+#include <algorithm>
+#include <cstdio>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+#include <triton/context.hpp>
+#include "Koi/pathtrace.h"
+#include "test.h"
+
+
+/**
+ * Build a path with every kind of entry.
+ * @param seed - Value that the entries are derived from.
+ * @return a path to write.
+ */
+static PathTrace makePath(triton::uint64 seed) {
+    PathTrace p;
+    p.reason = seed % 7;
+    p.endPc = 0x401000 + seed;
+    p.pcs = {0x401000, 0x401004, 0x401008, 0x400ff0, 0x7fff00000000, 0x401010 + seed};
+    p.branches = {{0x401004, false}, {0x401008, true}, {0x400ff0, seed & 1}};
+    p.decisions = {{0x401008, true}};
+    p.hooks = {{0x401010, 0x400500, seed}, {0x401020, 0x400510, ~triton::uint64(0)}};
+    p.regions = {{0x10000000, 0x20, true}, {0x7fffff00, 0x40, false}};
+    return p;
+}
+
+
+/**
+ * Check that two paths are the same.
+ * @param a - First path.
+ * @param b - Second path.
+ * @return true if every entry is the same.
+ */
+static bool samePath(const PathTrace& a, const PathTrace& b) {
+    if(a.reason != b.reason || a.endPc != b.endPc || a.pcs != b.pcs
+    || a.branches != b.branches || a.decisions != b.decisions
+    || a.hooks.size() != b.hooks.size() || a.regions.size() != b.regions.size())
+        return false;
+    for(size_t i = 0; i < a.hooks.size(); i++) {
+        if(a.hooks[i].pc != b.hooks[i].pc || a.hooks[i].dst != b.hooks[i].dst || a.hooks[i].ret != b.hooks[i].ret)
+            return false;
+    }
+    for(size_t i = 0; i < a.regions.size(); i++) {
+        if(a.regions[i].ptr != b.regions[i].ptr || a.regions[i].len != b.regions[i].len || a.regions[i].heap != b.regions[i].heap)
+            return false;
+    }
+    return true;
+}
+
+
+/**
+ * Paths read back the same as they were written, addresses going either way.
+ */
+static void testRoundTrip() {
+    std::stringstream ss;
+    for(triton::uint64 i = 0; i < 3; i++)
+        makePath(i).write(ss);
+
+    PathTrace p;
+    for(triton::uint64 i = 0; i < 3; i++) {
+        CHECK(p.read(ss));
+        CHECK(samePath(p, makePath(i)));
+    }
+    CHECK(!p.read(ss));
+}
+
+
+/**
+ * An empty path is still a path.
+ */
+static void testEmpty() {
+    std::stringstream ss;
+    PathTrace().write(ss);
+    PathTrace p = makePath(1);
+    CHECK(p.read(ss));
+    CHECK(samePath(p, PathTrace()));
+}
+
+
+/**
+ * A path cut short is not read, wherever it is cut.
+ */
+static void testTruncated() {
+    std::stringstream ss;
+    makePath(2).write(ss);
+    std::string whole = ss.str();
+    for(size_t n = 0; n < whole.size(); n++) {
+        std::stringstream cut(whole.substr(0, n));
+        PathTrace p;
+        CHECK(!p.read(cut));
+    }
+}
+
+
+/**
+ * A trace file is loaded after its magic number, dropping a truncated path.
+ * @param dir - Directory for the trace files.
+ */
+static void testLoad(const std::string& dir) {
+    std::string file = dir + "/pathtrace.trace";
+    {
+        std::ofstream out(file, std::ios::binary | std::ios::trunc);
+        out.write(PathTrace::MAGIC, sizeof(PathTrace::MAGIC));
+        makePath(3).write(out);
+        makePath(4).write(out);
+        std::stringstream ss;
+        makePath(5).write(ss);
+        out << ss.str().substr(0, ss.str().size() / 2);
+    }
+    std::vector<PathTrace> paths = PathTrace::load(file);
+    CHECK(paths.size() == 2);
+    CHECK(paths.size() == 2 && samePath(paths[0], makePath(3)) && samePath(paths[1], makePath(4)));
+
+    // A file of another format, or another version, is not a trace file
+    {
+        std::ofstream out(file, std::ios::binary | std::ios::trunc);
+        char magic[sizeof(PathTrace::MAGIC)];
+        std::copy(PathTrace::MAGIC, PathTrace::MAGIC + sizeof(magic), magic);
+        magic[sizeof(magic) - 1]++;
+        out.write(magic, sizeof(magic));
+        makePath(3).write(out);
+    }
+    CHECK(PathTrace::load(file).empty());
+    CHECK(PathTrace::load(dir + "/missing.trace").empty());
+    std::remove(file.c_str());
+}
+
+
+int main(int argc, char *argv[]) {
+    std::string dir = argc > 1 ? argv[1] : "build/tests";
+    testRoundTrip();
+    testEmpty();
+    testTruncated();
+    testLoad(dir);
+    return testResult("pathtrace");
+}
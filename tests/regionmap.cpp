@@ -0,0 +1,127 @@
+#include <triton/context.hpp>
+#include "Koi/regionmap.h"
+#include "test.h"
+
+
+/**
+ * Get the tag of the region containing an address.
+ * @param m - Region map to search.
+ * @param ptr - Address to classify.
+ * @return the tag of the region, or -1 if there is none.
+ */
+static triton::uint64 tagAt(RegionMap& m, triton::uint64 ptr) {
+    const RegionMap::Entry *e = m.find(ptr);
+    return e == nullptr ? triton::uint64(-1) : e->tag;
+}
+
+
+/**
+ * Addresses are found within their region, inclusive of both ends.
+ */
+static void testFind() {
+    RegionMap m;
+    m.insert(0x1000, 0x1fff, RegionMap::Section, 5, ".text");
+    m.insert(0x3000, 0x30ff, RegionMap::Heap, 0x3000);
+    CHECK(m.find(0xfff) == nullptr);
+    CHECK(tagAt(m, 0x1000) == 5);
+    CHECK(tagAt(m, 0x1fff) == 5);
+    CHECK(m.find(0x2000) == nullptr);
+    CHECK(m.find(0x1800) != nullptr && m.find(0x1800)->name == ".text");
+    CHECK(m.find(0x30ff) != nullptr && m.find(0x30ff)->kind == RegionMap::Heap);
+    CHECK(m.find(0x3100) == nullptr);
+    CHECK(m.size() == 2);
+
+    // An empty range is never added
+    m.insert(0x5000, 0x4fff, RegionMap::Heap, 0x5000);
+    CHECK(m.size() == 2);
+}
+
+
+/**
+ * A region replaces the regions it overlaps, unless both are stack regions.
+ */
+static void testReplace() {
+    RegionMap m;
+    m.insert(0x1000, 0x10ff, RegionMap::Heap, 0x1000);
+    m.insert(0x1100, 0x11ff, RegionMap::Heap, 0x1100);
+    m.insert(0x1080, 0x117f, RegionMap::Heap, 0x1080);
+    CHECK(m.size() == 1);
+    CHECK(tagAt(m, 0x1000) == triton::uint64(-1));
+    CHECK(tagAt(m, 0x10a0) == 0x1080);
+
+    // Erasing the replacing region leaves nothing behind
+    CHECK(m.erase(0x1080));
+    CHECK(m.size() == 0);
+    CHECK(!m.erase(0x1080));
+}
+
+
+/**
+ * A frame overlapping its caller nests within it, and the caller is whole again once it is erased.
+ */
+static void testNested() {
+    RegionMap m;
+    m.insert(0x7f00, 0x7fff, RegionMap::Stack, 0);
+    m.insert(0x7e80, 0x7f3f, RegionMap::Stack, 1);
+    CHECK(tagAt(m, 0x7f40) == 0);
+    CHECK(tagAt(m, 0x7f3f) == 1);
+    CHECK(tagAt(m, 0x7e80) == 1);
+
+    // A frame within both of them
+    m.insert(0x7f10, 0x7f1f, RegionMap::Stack, 2);
+    CHECK(tagAt(m, 0x7f0f) == 1);
+    CHECK(tagAt(m, 0x7f10) == 2);
+    CHECK(tagAt(m, 0x7f20) == 1);
+
+    // Innermost first, each erase restores what it covered
+    CHECK(m.erase(0x7f10));
+    CHECK(tagAt(m, 0x7f10) == 1);
+    CHECK(tagAt(m, 0x7f20) == 1);
+    CHECK(m.erase(0x7e80));
+    CHECK(tagAt(m, 0x7e80) == triton::uint64(-1));
+    CHECK(tagAt(m, 0x7f00) == 0);
+    CHECK(tagAt(m, 0x7f3f) == 0);
+    CHECK(m.size() == 1);
+    const RegionMap::Entry *e = m.find(0x7f80);
+    CHECK(e != nullptr && e->lo == 0x7f00 && e->hi == 0x7fff);
+
+    // A frame at the same address as its caller
+    m.insert(0x7f00, 0x7f7f, RegionMap::Stack, 1);
+    CHECK(tagAt(m, 0x7f00) == 1);
+    CHECK(tagAt(m, 0x7f80) == 0);
+    CHECK(m.erase(0x7f00));
+    CHECK(tagAt(m, 0x7f00) == 0);
+    CHECK(m.size() == 1);
+}
+
+
+/**
+ * Clearing a kind leaves the other kinds, and forgets nested stack regions.
+ */
+static void testClear() {
+    RegionMap m;
+    m.insert(0x1000, 0x1fff, RegionMap::Section, 0);
+    m.insert(0x3000, 0x30ff, RegionMap::Heap, 0x3000);
+    m.insert(0x7f00, 0x7fff, RegionMap::Stack, 0);
+    m.insert(0x7f80, 0x80ff, RegionMap::Stack, 1);
+    m.clear(RegionMap::Stack);
+    CHECK(m.size() == 2);
+    CHECK(m.find(0x7f00) == nullptr);
+
+    // A new frame at the old address restores nothing when erased
+    m.insert(0x7f80, 0x80ff, RegionMap::Stack, 0);
+    CHECK(m.erase(0x7f80));
+    CHECK(m.find(0x7f00) == nullptr);
+    m.clear(RegionMap::Heap);
+    CHECK(m.size() == 1);
+    CHECK(tagAt(m, 0x1000) == 0);
+}
+
+
+int main() {
+    testFind();
+    testReplace();
+    testNested();
+    testClear();
+    return testResult("regionmap");
+}
@@ -0,0 +1,89 @@
+#include <cstdio>
+#include <string>
+#include <vector>
+#include <triton/context.hpp>
+#include "Koi/pathtrace.h"
+#include "Koi/swimmer.h"
+#include "test.h"
+
+
+/* Ends of the paths explored or replayed, in order */
+static std::vector<Swimmer::PathEnd> ends;
+
+
+/**
+ * Note the end of a path.
+ * @param s - Swimmer of the path.
+ * @param reason - Why the path terminated.
+ * @param pc - Address of the final instruction.
+ */
+static void notePath(Swimmer *s, Swimmer::PathEnd reason, triton::uint64 pc) {
+    (void)s;
+    (void)pc;
+    ends.push_back(reason);
+}
+
+
+/**
+ * Paths recorded while exploring replay to the same end, including the
+ * branch before the first fork that only has one feasible side.
+ * @param dir - Directory of the test build.
+ */
+static void testRoundTrip(const std::string& dir) {
+    std::string file = dir + "/replay.trace";
+    Swimmer s(dir + "/input_exe/branches");
+    triton::uint64 classify = s.getSymbolAddress("classify");
+    CHECK(classify != 0);
+    s.hookPath(notePath);
+
+    // Record both sides of the fork
+    ends.clear();
+    s.setPc(classify);
+    CHECK(s.recordPaths(file));
+    s.explore();
+    CHECK(s.recordPaths(""));
+    CHECK(ends.size() == 2);
+
+    // Each path passed the unforked branch, then forked once
+    std::vector<PathTrace> paths = PathTrace::load(file);
+    CHECK(paths.size() == 2);
+    for(const PathTrace& path : paths) {
+        CHECK(path.reason == Swimmer::Return);
+        CHECK(path.branches.size() == 2);
+        CHECK(path.decisions.size() == 1);
+        if(path.branches.size() == 2 && path.decisions.size() == 1) {
+            CHECK(path.branches[0].first != path.decisions[0].first);
+            CHECK(path.branches[1] == path.decisions[0]);
+        }
+    }
+    if(paths.size() == 2)
+        CHECK(paths[0].branches[1].second != paths[1].branches[1].second);
+
+    // Each path replays from the same state
+    for(const PathTrace& path : paths) {
+        ends.clear();
+        s.reset();
+        s.setPc(classify);
+        CHECK(s.replay(path));
+        CHECK(ends.size() == 1 && ends[0] == Swimmer::Return);
+    }
+
+    // A path whose branch was flipped diverges
+    if(!paths.empty() && !paths[0].branches.empty()) {
+        PathTrace flipped = paths[0];
+        flipped.branches[0].second = !flipped.branches[0].second;
+        ends.clear();
+        s.reset();
+        s.setPc(classify);
+        CHECK(!s.replay(flipped));
+        CHECK(ends.size() == 1 && ends[0] == Swimmer::Diverged);
+    }
+    std::remove(file.c_str());
+}
+
+
+int main(int argc, char *argv[]) {
+    std::string dir = argc > 1 ? argv[1] : "build/tests";
+    testRoundTrip(dir);
+    return testResult("replay");
+}
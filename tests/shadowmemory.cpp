@@ -0,0 +1,77 @@
+#include <triton/context.hpp>
+#include "Koi/shadowmemory.h"
+#include "test.h"
+
+
+/**
+ * Memory is unallocated until set, and set ranges may cross pages.
+ */
+static void testSet() {
+    ShadowMemory m;
+    CHECK(m.get(0x1234) == ShadowMemory::Unallocated);
+
+    m.set(0x1ff0, 0x20, ShadowMemory::Live);
+    CHECK(m.get(0x1fef) == ShadowMemory::Unallocated);
+    CHECK(m.get(0x1ff0) == ShadowMemory::Live);
+    CHECK(m.get(0x2000) == ShadowMemory::Live);
+    CHECK(m.get(0x200f) == ShadowMemory::Live);
+    CHECK(m.get(0x2010) == ShadowMemory::Unallocated);
+
+    // Later states overwrite earlier ones
+    m.set(0x2000, 0x8, ShadowMemory::Freed);
+    CHECK(m.get(0x1fff) == ShadowMemory::Live);
+    CHECK(m.get(0x2000) == ShadowMemory::Freed);
+    CHECK(m.get(0x2008) == ShadowMemory::Live);
+    m.set(0x1ff0, 0x20, ShadowMemory::Unallocated);
+    CHECK(m.get(0x2000) == ShadowMemory::Unallocated);
+
+    // Nothing is set by an empty range
+    m.set(0x5000, 0, ShadowMemory::Live);
+    CHECK(m.get(0x5000) == ShadowMemory::Unallocated);
+}
+
+
+/**
+ * A check finds the first poisoned byte of a range.
+ */
+static void testCheck() {
+    const triton::uint32 poison = (1 << ShadowMemory::Freed) | (1 << ShadowMemory::Redzone);
+    ShadowMemory m;
+    m.set(0x1000, 0x10, ShadowMemory::Live);
+    m.set(0x1010, 0x10, ShadowMemory::Redzone);
+    m.set(0x2ffc, 0x8, ShadowMemory::Freed);
+
+    triton::uint64 bad = 0;
+    CHECK(!m.check(0x1000, 0x10, poison, &bad));
+    CHECK(m.check(0x1008, 0x10, poison, &bad));
+    CHECK(bad == 0x1010);
+    CHECK(m.check(0x2ff0, 0x20, poison, &bad));
+    CHECK(bad == 0x2ffc);
+    CHECK(!m.check(0x3004, 0x10, poison));
+
+    // Missing pages are unallocated, which is only poisoned when asked
+    CHECK(!m.check(0x9000, 0x10, poison));
+    CHECK(m.check(0x9000, 0x10, poison | (1 << ShadowMemory::Unallocated), &bad));
+    CHECK(bad == 0x9000);
+    CHECK(m.check(0x1000, 0x10, 1 << ShadowMemory::Live, &bad));
+    CHECK(bad == 0x1000);
+}
+
+
+/**
+ * Clearing forgets the state of all memory.
+ */
+static void testClear() {
+    ShadowMemory m;
+    m.set(0x1000, 0x10, ShadowMemory::StackLocal);
+    m.clear();
+    CHECK(m.get(0x1000) == ShadowMemory::Unallocated);
+}
+
+
+int main() {
+    testSet();
+    testCheck();
+    testClear();
+    return testResult("shadowmemory");
+}
@@ -0,0 +1,65 @@
+#include <triton/context.hpp>
+#include "Koi/stackframe.h"
+#include "test.h"
+
+
+/**
+ * The gap of an offset reaches up to the nearest access towards the base.
+ */
+static void testAccessGap() {
+    Stackframe sf(0x7fff0000, 0x40);
+    CHECK(sf.addAccess(0x10));
+    CHECK(sf.addAccess(0x30));
+    CHECK(!sf.addAccess(0x30));
+    CHECK(sf.getAccessGap(0x30) == 0x20);
+    CHECK(sf.getAccessGap(0x10) == 0x10);
+    CHECK(sf.getAccessGap(0x20) == 0x10);
+    CHECK(sf.getAccessGap(0x40) == 0x10);
+    CHECK(sf.getAccessGap(0) == 0);
+}
+
+
+/**
+ * The layout follows the accesses, including removed ones.
+ */
+static void testLayout() {
+    Stackframe sf(0x7fff0000, 0x40);
+    sf.addAccess(0x10);
+    const std::vector<Stackframe::Slot>& before = sf.getLayout();
+    CHECK(before.size() == 2);
+    CHECK(before.size() == 2 && before[0].offs == 0x10 && before[0].len == 0x10);
+    CHECK(before.size() == 2 && before[1].offs == 0x40 && before[1].len == 0x30);
+
+    // Removing an access merges its slot into the next
+    sf.addAccess(0x20);
+    CHECK(sf.getLayout().size() == 3);
+    sf.removeAccess(0x20);
+    sf.removeAccess(0x28);
+    const std::vector<Stackframe::Slot>& after = sf.getLayout();
+    CHECK(after.size() == 2);
+    CHECK(after.size() == 2 && after[1].offs == 0x40 && after[1].len == 0x30);
+    CHECK(sf.getAccessGap(0x20) == 0x10);
+}
+
+
+/**
+ * Updating a frame forgets its accesses.
+ */
+static void testUpdate() {
+    Stackframe sf;
+    sf.update(0x7fff0000, 0x20);
+    CHECK(sf.getAddress() == 0x7fff0000);
+    CHECK(sf.getSize() == 0x20);
+    sf.addAccess(0x8);
+    sf.update(0x7ffe0000, 0x30);
+    CHECK(sf.getLayout().size() == 1);
+    CHECK(sf.getAccessGap(0x8) == 0x8);
+}
+
+
+int main() {
+    testAccessGap();
+    testLayout();
+    testUpdate();
+    return testResult("stackframe");
+}
@@ -0,0 +1,35 @@
+#ifndef TEST_H
+#define TEST_H
+
+#include <iostream>
+
+
+/* Failed checks are counted, and a test program exits with failure if any did */
+inline int testFailures = 0;
+
+
+/* Check a condition, reporting where it failed without stopping the test */
+#define CHECK(cond)                                                                       \
+    do {                                                                                  \
+        if(!(cond)) {                                                                     \
+            std::cerr << __FILE__ << ":" << __LINE__ << ": CHECK(" #cond ") failed" << std::endl; \
+            testFailures++;                                                               \
+        }                                                                                 \
+    } while(0)
+
+
+/**
+ * Report the result of a test program.
+ * @param name - Name of the test program.
+ * @return the exit status of the test program.
+ */
+inline int testResult(const char *name) {
+    if(testFailures)
+        std::cerr << name << ": " << testFailures << " checks failed" << std::endl;
+    else
+        std::cout << name << ": passed" << std::endl;
+    return testFailures ? 1 : 0;
+}
+
+
+#endif
@@ -0,0 +1,113 @@
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include <triton/context.hpp>
+#include "Koi/tracesink.h"
+#include "test.h"
+
+
+/* Records written by the sink, collected from its background thread */
+static std::mutex written;
+static std::vector<TraceSink::Record> records;
+
+
+/**
+ * Collect a record written by the sink.
+ * @param r - Record to collect.
+ */
+static void collect(const TraceSink::Record& r) {
+    std::lock_guard<std::mutex> guard(written);
+    records.push_back(r);
+}
+
+
+/**
+ * Records are written in the order they were added, with their values.
+ */
+static void testOrder() {
+    records.clear();
+    TraceSink sink(collect);
+    for(triton::uint64 i = 0; i < 1000; i++)
+        sink.push(TraceSink::Insn, i, i * 2, 1, 2, "nop");
+    sink.flush();
+
+    std::lock_guard<std::mutex> guard(written);
+    CHECK(records.size() == 1000);
+    for(size_t i = 0; i < records.size(); i++) {
+        CHECK(records[i].kind == TraceSink::Insn);
+        CHECK(records[i].a == i);
+        CHECK(records[i].b == i * 2);
+        CHECK(records[i].fid == 1 && records[i].depth == 2);
+        CHECK(std::string(records[i].text) == "nop");
+    }
+    CHECK(sink.getDropped() == 0);
+}
+
+
+/**
+ * Text longer than a record is truncated, never overflowing it.
+ */
+static void testTruncation() {
+    records.clear();
+    TraceSink sink(collect);
+    std::string text(200, 'x');
+    sink.push(TraceSink::Insn, 0, 0, 0, 0, text.c_str());
+    sink.flush();
+
+    std::lock_guard<std::mutex> guard(written);
+    CHECK(records.size() == 1);
+    CHECK(std::string(records[0].text) == text.substr(0, sizeof(records[0].text) - 1));
+}
+
+
+/**
+ * A full ring buffer drops records instead of blocking, and reports them on flush.
+ */
+static void testDropped() {
+    records.clear();
+    std::atomic<bool> gate(false);
+    TraceSink sink([&gate](const TraceSink::Record& r) {
+        while(!gate.load())
+            std::this_thread::yield();
+        collect(r);
+    }, 3);
+
+    // The capacity is rounded up to 4, and the writer holds the first record until the gate opens
+    for(triton::uint64 i = 0; i < 10; i++)
+        sink.push(TraceSink::Insn, i);
+    CHECK(sink.getDropped() == 6);
+    gate = true;
+    sink.flush();
+
+    std::lock_guard<std::mutex> guard(written);
+    CHECK(records.size() == 5);
+    for(size_t i = 0; i < 4 && i < records.size(); i++)
+        CHECK(records[i].kind == TraceSink::Insn && records[i].a == i);
+    CHECK(records.size() == 5 && records[4].kind == TraceSink::Dropped && records[4].a == 6);
+}
+
+
+/**
+ * Destroying the sink writes the records that are left.
+ */
+static void testDestructor() {
+    records.clear();
+    {
+        TraceSink sink(collect);
+        for(triton::uint64 i = 0; i < 100; i++)
+            sink.push(TraceSink::Insn, i);
+    }
+    std::lock_guard<std::mutex> guard(written);
+    CHECK(records.size() == 100);
+}
+
+
+int main() {
+    testOrder();
+    testTruncation();
+    testDropped();
+    testDestructor();
+    return testResult("tracesink");
+}